@@ -0,0 +1,898 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <ctime>
+#include <cstddef>
+#include <cstring>
+#include <sstream>
+#include <thread>
+#include "btree.h"
+#include "filescan.h"
+#include "key_search.h"
+#include "exceptions/end_of_file_exception.h"
+#include "exceptions/file_not_found_exception.h"
+#include "exceptions/hash_not_found_exception.h"
+#include "exceptions/insufficient_space_exception.h"
+#include "exceptions/index_scan_completed_exception.h"
+#include "exceptions/no_such_key_found_exception.h"
+
+using namespace badgerdb;
+
+// -----------------------------------------------------------------------------
+// Globals
+// -----------------------------------------------------------------------------
+const int searchesPerRun = 4000000;
+const std::string benchRelationName = "bench_rel";
+const int numProbes = 20000;
+const int probeBatchSize = 1000;
+volatile int sink;
+volatile double dsink;
+
+//same layout as the tuples main.cpp builds its relations from
+struct BenchRecord
+{
+	int i;
+	double d;
+	char s[64];
+};
+
+// -----------------------------------------------------------------------------
+// Forward declarations
+// -----------------------------------------------------------------------------
+double elapsedNs(const timespec &start, const timespec &stop);
+void fillSortedKeys(std::vector<int> &keys, const int numKeys);
+bool checkKernel(IntKeySearch kernel, const std::vector<int> &keys, const std::vector<int> &probes);
+double timeKernel(IntKeySearch kernel, const std::vector<int> &keys, const std::vector<int> &probes, const bool upper);
+void keySearchBench(const char *nodeName, const int numKeys);
+void removeFile(const std::string &fileName);
+void printIOStats(const char *phase, const int numOps, const double ns, BufMgr *bufMgr);
+void indexIOBench(const int numEntries, const int numKeys, const int numScans, const int numBufs, const LeafFormat leafFormat);
+void fillRelation(PageFile &file, const int numRecords);
+void columnScanBench(const int numRecords);
+void bufferHitBench(const int numPages);
+void pinWorker(BufMgr *bufMgr, File *file, const int numPages, const int numOps, const int seed);
+void policyBench(const int numEntries, const int numBufs);
+void ringScanBench(const int numRecords, const int numBufs);
+
+int main(int argc, char **argv)
+{
+	srand(1);
+
+	//the first search resolves the kernel
+	int probe = 0;
+	sink = findKeyIndex(&probe, 1, probe, false);
+	std::cout << "key search kernel picked for this CPU: " << keySearchName(intKeySearch.load()) << "\n";
+
+	keySearchBench("LeafNodeInt", LeafNodeInt::PLAINSIZE);
+	keySearchBench("NonLeafNodeInt", INTARRAYNONLEAFSIZE);
+	keySearchBench("half full NonLeafNodeInt", INTARRAYNONLEAFSIZE / 2);
+
+	indexIOBench(200000, 800000, 2000, 100, PLAIN_LEAF);
+	indexIOBench(200000, 800000, 2000, 2000, PLAIN_LEAF);
+	indexIOBench(200000, 800000, 2000, 2000, POSTING_LEAF);
+	indexIOBench(200000, 100, 2000, 2000, PLAIN_LEAF);
+	indexIOBench(200000, 100, 2000, 2000, POSTING_LEAF);
+
+	columnScanBench(200000);
+
+	bufferHitBench(1000);
+
+	policyBench(200000, 100);
+
+	ringScanBench(200000, 200);
+
+	return 0;
+}
+
+double elapsedNs(const timespec &start, const timespec &stop)
+{
+	return (stop.tv_sec - start.tv_sec) * 1e9 + (stop.tv_nsec - start.tv_nsec);
+}
+
+void fillSortedKeys(std::vector<int> &keys, const int numKeys)
+{
+	keys.resize(numKeys);
+
+	//small range so that runs of duplicate keys show up as well
+	for(int i = 0; i < numKeys; i++)
+	{
+		keys[i] = rand() % (numKeys * 4);
+	}
+
+	std::sort(keys.begin(), keys.end());
+}
+
+bool checkKernel(IntKeySearch kernel, const std::vector<int> &keys, const std::vector<int> &probes)
+{
+	for(int n = 0; n <= (int)keys.size(); n++)
+	{
+		for(size_t i = 0; i < probes.size(); i += 7)
+		{
+			for(int upper = 0; upper < 2; upper++)
+			{
+				if(kernel(&keys[0], n, probes[i], upper) != findKeyIndexIntScalar(&keys[0], n, probes[i], upper))
+				{
+					std::cout << keySearchName(kernel) << " disagrees with scalar search, numKeys " << n << " key " << probes[i] << "\n";
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+double timeKernel(IntKeySearch kernel, const std::vector<int> &keys, const std::vector<int> &probes, const bool upper)
+{
+	timespec start, stop;
+	int total = 0;
+	const int numKeys = keys.size();
+	const int mask = probes.size() - 1;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for(int i = 0; i < searchesPerRun; i++)
+	{
+		total += kernel(&keys[0], numKeys, probes[i & mask], upper);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &stop);
+
+	sink = total;
+	return elapsedNs(start, stop) / searchesPerRun;
+}
+
+// -----------------------------------------------------------------------------
+// keySearchBench
+// -----------------------------------------------------------------------------
+//compares every kernel this CPU can run against the scalar search on a node
+//worth of sorted keys, probed with random keys
+void keySearchBench(const char *nodeName, const int numKeys)
+{
+	std::vector<int> keys;
+	std::vector<int> probes(1 << 16);
+
+	fillSortedKeys(keys, numKeys);
+
+	for(size_t i = 0; i < probes.size(); i++)
+	{
+		probes[i] = rand() % (numKeys * 4 + 2) - 1;
+	}
+
+	IntKeySearch kernels[] = {findKeyIndexIntScalar, findKeyIndexIntSSE42, findKeyIndexIntAVX2};
+
+	std::cout << "\n" << nodeName << ", " << numKeys << " keys, ns per search\n";
+	std::cout << std::setw(10) << "kernel" << std::setw(14) << "lower bound" << std::setw(14) << "upper bound" << "\n";
+
+	for(int k = 0; k < 3; k++)
+	{
+		if(!keySearchSupported(kernels[k]))
+		{
+			std::cout << std::setw(10) << keySearchName(kernels[k]) << "  not supported on this CPU\n";
+			continue;
+		}
+
+		if(!checkKernel(kernels[k], keys, probes))
+		{
+			exit(1);
+		}
+
+		double lower = timeKernel(kernels[k], keys, probes, false);
+		double upper = timeKernel(kernels[k], keys, probes, true);
+
+		std::cout << std::setw(10) << keySearchName(kernels[k]) << std::fixed << std::setprecision(2)
+			<< std::setw(14) << lower << std::setw(14) << upper << "\n";
+	}
+}
+
+void removeFile(const std::string &fileName)
+{
+	try
+	{
+		File::remove(fileName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+}
+
+void printIOStats(const char *phase, const int numOps, const double ns, BufMgr *bufMgr)
+{
+	BufStats &stats = bufMgr->getBufStats();
+
+	std::cout << std::setw(10) << phase << std::setw(10) << numOps << std::fixed << std::setprecision(0)
+		<< std::setw(14) << ns / numOps << std::setw(12) << stats.diskreads << std::setw(12) << stats.diskwrites << "\n";
+
+	bufMgr->clearBufStats();
+}
+
+// -----------------------------------------------------------------------------
+// indexIOBench
+// -----------------------------------------------------------------------------
+//inserts random INTEGER keys, drawn from numKeys values, into an empty
+//index with leaves of the given format, runs range scans and point lookups
+//over it through a small buffer pool, reporting the disk reads and writes
+//each phase costs
+void indexIOBench(const int numEntries, const int numKeys, const int numScans, const int numBufs, const LeafFormat leafFormat)
+{
+	removeFile(benchRelationName);
+	removeFile(benchRelationName + ".0");
+
+	{
+		PageFile::create(benchRelationName);
+	}
+
+	BufMgr *bufMgr = new BufMgr(numBufs);
+	std::string indexName;
+	timespec start, stop;
+
+	std::cout << "\nINTEGER index, " << (leafFormat == PLAIN_LEAF ? "plain" : "posting") << " leaves, " << numEntries << " random inserts over " << numKeys << " keys, " << numScans << " scans, " << numBufs << " buffer frames\n";
+	std::cout << std::setw(10) << "phase" << std::setw(10) << "ops" << std::setw(14) << "ns per op"
+		<< std::setw(12) << "diskreads" << std::setw(12) << "diskwrites" << "\n";
+
+	{
+		BTreeIndex index(benchRelationName, indexName, bufMgr, 0, INTEGER, BULKLOAD_FILLFACTOR, BULKLOAD_RUNSIZE, leafFormat);
+
+		bufMgr->clearBufStats();
+		clock_gettime(CLOCK_MONOTONIC, &start);
+
+		for(int i = 0; i < numEntries; i++)
+		{
+			int key = rand() % numKeys;
+			RecordId rid;
+			rid.page_number = i / 100 + 1;
+			rid.slot_number = i % 100;
+
+			index.insertEntry(&key, rid);
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &stop);
+		printIOStats("insert", numEntries, elapsedNs(start, stop), bufMgr);
+
+		//each scan covers about a thousand entries, or a single key when
+		//keys repeat more often than that
+		int scanWidth = std::max(1, (int)(1000LL * numKeys / numEntries));
+		clock_gettime(CLOCK_MONOTONIC, &start);
+
+		int total = 0;
+
+		for(int i = 0; i < numScans; i++)
+		{
+			int lowVal = rand() % numKeys;
+			int highVal = lowVal + scanWidth;
+			RecordId rid;
+
+			try
+			{
+				index.startScan(&lowVal, GTE, &highVal, LT);
+
+				while(1)
+				{
+					index.scanNext(rid);
+					total++;
+				}
+			}
+			catch(IndexScanCompletedException e)
+			{
+			}
+			catch(NoSuchKeyFoundException e)
+			{
+			}
+
+			index.endScan();
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &stop);
+		sink = total;
+		printIOStats("scan", numScans, elapsedNs(start, stop), bufMgr);
+
+		//the same random probes one by one, then a thousand at a time
+		std::vector<int> probes(numProbes);
+		std::vector<const void*> probePtrs(numProbes);
+
+		for(int i = 0; i < numProbes; i++)
+		{
+			probes[i] = rand() % numKeys;
+			probePtrs[i] = &probes[i];
+		}
+
+		std::vector<RecordId> rids;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+
+		for(int i = 0; i < numProbes; i++)
+		{
+			rids.clear();
+			index.lookup(&probes[i], rids);
+			total += rids.size();
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &stop);
+		printIOStats("lookup", numProbes, elapsedNs(start, stop), bufMgr);
+
+		std::vector< std::vector<RecordId> > batchRids;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+
+		for(int i = 0; i < numProbes; i += probeBatchSize)
+		{
+			index.lookupBatch(&probePtrs[i], std::min(probeBatchSize, numProbes - i), batchRids);
+
+			for(size_t j = 0; j < batchRids.size(); j++)
+			{
+				total += batchRids[j].size();
+			}
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &stop);
+		sink = total;
+		printIOStats("batch", numProbes, elapsedNs(start, stop), bufMgr);
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		index.checkpoint();
+		clock_gettime(CLOCK_MONOTONIC, &stop);
+		printIOStats("checkpoint", 1, elapsedNs(start, stop), bufMgr);
+	}
+
+	delete bufMgr;
+	removeFile(indexName);
+	removeFile(benchRelationName);
+}
+
+void fillRelation(PageFile &file, const int numRecords)
+{
+	BenchRecord record;
+	memset(&record, 0, sizeof(record));
+	PageId pageNo;
+	Page page = file.allocatePage(pageNo);
+
+	for(int i = 0; i < numRecords; i++)
+	{
+		record.i = i;
+		record.d = i;
+
+		try
+		{
+			page.insertRecord(reinterpret_cast<char*>(&record), sizeof(record));
+		}
+		catch(InsufficientSpaceException e)
+		{
+			file.writePage(pageNo, page);
+			page = file.allocatePage(pageNo);
+			page.insertRecord(reinterpret_cast<char*>(&record), sizeof(record));
+		}
+	}
+
+	file.writePage(pageNo, page);
+}
+
+// -----------------------------------------------------------------------------
+// columnScanBench
+// -----------------------------------------------------------------------------
+//sums the d attribute of a relation stored on slotted pages through
+//FileScan::getRecord, and of the same relation stored on PAX pages through
+//FileScan::scanNextColumn, with every page already in the buffer pool
+void columnScanBench(const int numRecords)
+{
+	std::vector<PageColumn> columns(3);
+	columns[0].offset = offsetof(BenchRecord, i);
+	columns[0].size = sizeof(int);
+	columns[1].offset = offsetof(BenchRecord, d);
+	columns[1].size = sizeof(double);
+	columns[2].offset = offsetof(BenchRecord, s);
+	columns[2].size = 64;
+
+	std::cout << "\nsum of one double column over " << numRecords << " records\n";
+	std::cout << std::setw(10) << "layout" << std::setw(10) << "pages" << std::setw(14) << "ns per record"
+		<< std::setw(18) << "bytes per record" << "\n";
+
+	for(int pax = 0; pax < 2; pax++)
+	{
+		removeFile(benchRelationName);
+
+		int numPages = 0;
+		{
+			PageFile file = pax ? PageFile::create(benchRelationName, sizeof(BenchRecord), columns) : PageFile::create(benchRelationName);
+			fillRelation(file, numRecords);
+
+			for(FileIterator iter = file.begin(); iter != file.end(); ++iter)
+			{
+				numPages++;
+			}
+		}
+
+		BufMgr *bufMgr = new BufMgr(numPages + 10);
+		double best = 0;
+
+		//the first pass reads the pages in, the others run from the pool
+		for(int pass = 0; pass < 4; pass++)
+		{
+			timespec start, stop;
+			double sum = 0;
+			FileScan fscan(benchRelationName, bufMgr);
+
+			clock_gettime(CLOCK_MONOTONIC, &start);
+
+			try
+			{
+				if(pax)
+				{
+					ColumnVector column;
+
+					while(1)
+					{
+						fscan.scanNextColumn(1, column);
+
+						for(SlotId slot = 1; slot <= column.num_slots; slot++)
+						{
+							if((column.used[(slot - 1) / 32] >> ((slot - 1) % 32)) & 1)
+							{
+								sum += *reinterpret_cast<const double*>(column.values + (slot - 1) * column.value_size);
+							}
+						}
+					}
+				}
+				else
+				{
+					RecordId rid;
+
+					while(1)
+					{
+						fscan.scanNext(rid);
+						std::string record = fscan.getRecord();
+						sum += *reinterpret_cast<const double*>(record.data() + offsetof(BenchRecord, d));
+					}
+				}
+			}
+			catch(EndOfFileException e)
+			{
+			}
+
+			clock_gettime(CLOCK_MONOTONIC, &stop);
+			dsink = sum;
+
+			double ns = elapsedNs(start, stop);
+			if(pass == 1 || (pass > 1 && ns < best))
+			{
+				best = ns;
+			}
+		}
+
+		std::cout << std::setw(10) << (pax ? "PAX" : "slotted") << std::setw(10) << numPages << std::fixed << std::setprecision(1)
+			<< std::setw(14) << best / numRecords << std::setw(18) << (pax ? sizeof(double) : sizeof(BenchRecord)) << "\n";
+
+		delete bufMgr;
+		removeFile(benchRelationName);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// bufferHitBench
+// -----------------------------------------------------------------------------
+//pins and unpins random pages that are all in the buffer pool, then compares
+//finding absent pages in the buffer hash table with and without exceptions
+void bufferHitBench(const int numPages)
+{
+	const int numOps = 1000000;
+	timespec start, stop;
+
+	removeFile(benchRelationName);
+
+	{
+		PageFile file = PageFile::create(benchRelationName);
+		PageId pageNo;
+
+		for(int i = 0; i < numPages; i++)
+		{
+			file.allocatePage(pageNo);
+		}
+	}
+
+	std::cout << "\nbuffer pool, " << numPages << " resident pages\n";
+	std::cout << std::setw(10) << "phase" << std::setw(10) << "ops" << std::setw(14) << "ns per op" << "\n";
+
+	{
+		PageFile file = PageFile::open(benchRelationName);
+		BufMgr *bufMgr = new BufMgr(numPages + 10);
+		Page *page;
+		std::vector<PageId> pageNos(numOps);
+
+		for(int i = 0; i < numOps; i++)
+		{
+			pageNos[i] = rand() % numPages + 1;
+		}
+
+		for(int i = 1; i <= numPages; i++)
+		{
+			bufMgr->readPage(&file, i, page);
+			bufMgr->unPinPage(&file, i, false);
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+
+		for(int i = 0; i < numOps; i++)
+		{
+			bufMgr->readPage(&file, pageNos[i], page);
+			bufMgr->unPinPage(&file, pageNos[i], false);
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &stop);
+		std::cout << std::setw(10) << "hit" << std::setw(10) << numOps << std::fixed << std::setprecision(1)
+			<< std::setw(14) << elapsedNs(start, stop) / numOps << "\n";
+
+		//the same pins from several threads at once, reporting the time per
+		//pin across all of them
+		for(int numThreads = 2; numThreads <= 8; numThreads *= 2)
+		{
+			std::vector<std::thread> workers;
+			clock_gettime(CLOCK_MONOTONIC, &start);
+
+			for(int t = 0; t < numThreads; t++)
+			{
+				workers.push_back(std::thread(pinWorker, bufMgr, &file, numPages, numOps / numThreads, t + 1));
+			}
+
+			for(int t = 0; t < numThreads; t++)
+			{
+				workers[t].join();
+			}
+
+			clock_gettime(CLOCK_MONOTONIC, &stop);
+			std::cout << std::setw(8) << "hit x" << numThreads << std::setw(10) << numOps
+				<< std::setw(14) << elapsedNs(start, stop) / numOps << "\n";
+		}
+
+		bufMgr->flushFile(&file);
+		delete bufMgr;
+
+		//the pages the pool would look up next, none of them resident
+		BufHashTbl hashTable(numPages * 6 / 5 + 1);
+		FrameId frameNo;
+		int found = 0;
+
+		for(int i = 1; i <= numPages; i++)
+		{
+			hashTable.insert(&file, i, i - 1);
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+
+		for(int i = 0; i < numOps; i++)
+		{
+			found += hashTable.find(&file, pageNos[i] + numPages, frameNo);
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &stop);
+		std::cout << std::setw(10) << "find miss" << std::setw(10) << numOps
+			<< std::setw(14) << elapsedNs(start, stop) / numOps << "\n";
+
+		const int numThrows = numOps / 10;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+
+		for(int i = 0; i < numThrows; i++)
+		{
+			try
+			{
+				hashTable.lookup(&file, pageNos[i] + numPages, frameNo);
+				found++;
+			}
+			catch(HashNotFoundException e)
+			{
+			}
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &stop);
+		sink = found;
+		std::cout << std::setw(10) << "throw miss" << std::setw(10) << numThrows
+			<< std::setw(14) << elapsedNs(start, stop) / numThrows << "\n";
+	}
+
+	removeFile(benchRelationName);
+}
+
+void pinWorker(BufMgr *bufMgr, File *file, const int numPages, const int numOps, const int seed)
+{
+	unsigned int state = seed;
+	Page *page;
+
+	for(int i = 0; i < numOps; i++)
+	{
+		state = state * 1103515245 + 12345;
+		PageId pageNo = (state >> 8) % numPages + 1;
+
+		bufMgr->readPage(file, pageNo, page);
+		bufMgr->unPinPage(file, pageNo, false);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// policyBench
+// -----------------------------------------------------------------------------
+//replays one trace of point lookups, all but one in fifty of them on a hot
+//tenth of the keys, broken up by range scans over a quarter of the keys, against an
+//INTEGER index through a small buffer pool under each replacement policy,
+//reporting the share of page accesses served without a disk read, then times
+//hits on pages all resident from one to eight threads under each policy
+void policyBench(const int numEntries, const int numBufs)
+{
+	const int numRounds = 20;
+	const int lookupsPerRound = 5000;
+	const int hotKeys = numEntries / 10;
+	const int scanWidth = numEntries / 4;
+	const BufPolicyType policies[] = {CLOCK_POLICY, LRUK_POLICY, TWOQ_POLICY, ARC_POLICY};
+	timespec start, stop;
+
+	removeFile(benchRelationName);
+	removeFile(benchRelationName + ".0");
+
+	{
+		PageFile::create(benchRelationName);
+	}
+
+	std::string indexName;
+
+	{
+		std::vector<int> keys(numEntries);
+
+		for(int i = 0; i < numEntries; i++)
+		{
+			keys[i] = i;
+		}
+
+		std::random_shuffle(keys.begin(), keys.end());
+
+		BufMgr *bufMgr = new BufMgr(2000);
+
+		{
+			BTreeIndex index(benchRelationName, indexName, bufMgr, 0, INTEGER);
+
+			for(int i = 0; i < numEntries; i++)
+			{
+				RecordId rid;
+				rid.page_number = i / 100 + 1;
+				rid.slot_number = i % 100;
+
+				index.insertEntry(&keys[i], rid);
+			}
+		}
+
+		delete bufMgr;
+	}
+
+	//opening the index prints, so the table goes out once every run is done
+	std::ostringstream table;
+	table << "\nINTEGER index, " << numEntries << " keys, " << numRounds * lookupsPerRound << " lookups and " << numRounds << " scans, " << numBufs << " buffer frames\n";
+	table << std::setw(10) << "policy" << std::setw(12) << "accesses" << std::setw(12) << "diskreads"
+		<< std::setw(12) << "hit ratio" << std::setw(14) << "ns per access" << "\n";
+
+	for(size_t p = 0; p < sizeof(policies) / sizeof(policies[0]); p++)
+	{
+		BufMgr *bufMgr = new BufMgr(numBufs, policies[p]);
+
+		{
+			BTreeIndex index(benchRelationName, indexName, bufMgr, 0, INTEGER);
+			std::vector<RecordId> rids;
+			int total = 0;
+
+			//every policy sees the same trace
+			srand(7);
+			bufMgr->clearBufStats();
+			clock_gettime(CLOCK_MONOTONIC, &start);
+
+			for(int round = 0; round < numRounds; round++)
+			{
+				for(int i = 0; i < lookupsPerRound; i++)
+				{
+					int key = rand() % 50 != 0 ? rand() % hotKeys : rand() % numEntries;
+
+					rids.clear();
+					index.lookup(&key, rids);
+					total += rids.size();
+				}
+
+				int lowVal = rand() % (numEntries - scanWidth);
+				int highVal = lowVal + scanWidth;
+				RecordId rid;
+
+				try
+				{
+					index.startScan(&lowVal, GTE, &highVal, LT);
+
+					while(1)
+					{
+						index.scanNext(rid);
+						total++;
+					}
+				}
+				catch(IndexScanCompletedException e)
+				{
+				}
+				catch(NoSuchKeyFoundException e)
+				{
+				}
+
+				index.endScan();
+			}
+
+			clock_gettime(CLOCK_MONOTONIC, &stop);
+			sink = total;
+
+			BufStats &stats = bufMgr->getBufStats();
+			table << std::setw(10) << bufMgr->policyName() << std::setw(12) << stats.accesses << std::setw(12) << stats.diskreads
+				<< std::fixed << std::setprecision(3) << std::setw(12) << 1.0 - (double)stats.diskreads / stats.accesses
+				<< std::setprecision(0) << std::setw(14) << elapsedNs(start, stop) / stats.accesses << "\n";
+		}
+
+		delete bufMgr;
+	}
+
+	std::cout << table.str();
+	removeFile(indexName);
+	removeFile(benchRelationName);
+
+	//hits on pages all resident, from several threads at once, since hits
+	//are where a policy's latch would make threads wait for each other
+	const int numOps = 1000000;
+	std::cout << "\nhits on " << numBufs << " resident pages, ns per hit across all threads\n";
+	std::cout << std::setw(10) << "policy";
+	for(int numThreads = 1; numThreads <= 8; numThreads *= 2)
+	{
+		std::cout << std::setw(8) << "x" << numThreads;
+	}
+	std::cout << "\n";
+
+	{
+		PageFile file = PageFile::create(benchRelationName);
+		PageId pageNo;
+
+		for(int i = 0; i < numBufs; i++)
+		{
+			file.allocatePage(pageNo);
+		}
+
+		for(size_t p = 0; p < sizeof(policies) / sizeof(policies[0]); p++)
+		{
+			BufMgr *bufMgr = new BufMgr(numBufs, policies[p]);
+			Page *page;
+
+			for(int i = 1; i <= numBufs; i++)
+			{
+				bufMgr->readPage(&file, i, page);
+				bufMgr->unPinPage(&file, i, false);
+			}
+
+			std::cout << std::setw(10) << bufMgr->policyName();
+
+			for(int numThreads = 1; numThreads <= 8; numThreads *= 2)
+			{
+				std::vector<std::thread> workers;
+				clock_gettime(CLOCK_MONOTONIC, &start);
+
+				for(int t = 0; t < numThreads; t++)
+				{
+					workers.push_back(std::thread(pinWorker, bufMgr, &file, numBufs, numOps / numThreads, t + 1));
+				}
+
+				for(int t = 0; t < numThreads; t++)
+				{
+					workers[t].join();
+				}
+
+				clock_gettime(CLOCK_MONOTONIC, &stop);
+				std::cout << std::fixed << std::setprecision(1) << std::setw(9) << elapsedNs(start, stop) / numOps;
+			}
+
+			std::cout << "\n";
+			bufMgr->flushFile(&file);
+			delete bufMgr;
+		}
+	}
+
+	removeFile(benchRelationName);
+}
+
+// -----------------------------------------------------------------------------
+// ringScanBench
+// -----------------------------------------------------------------------------
+//looks up a hot tenth of the keys of an INTEGER index on a relation, scans
+//the whole relation with and without a ring of frames, then repeats the
+//lookups, reporting the disk reads the scan and the lookups after it cost
+void ringScanBench(const int numRecords, const int numBufs)
+{
+	const int numLookups = 20000;
+	const std::uint32_t ringSizes[] = {0, BufRing::DEFAULT_SIZE};
+
+	removeFile(benchRelationName);
+	removeFile(benchRelationName + ".0");
+
+	{
+		PageFile file = PageFile::create(benchRelationName);
+		fillRelation(file, numRecords);
+	}
+
+	std::string indexName;
+
+	{
+		BufMgr *bufMgr = new BufMgr(2000);
+
+		{
+			BTreeIndex index(benchRelationName, indexName, bufMgr, offsetof(BenchRecord, i), INTEGER);
+		}
+
+		delete bufMgr;
+	}
+
+	std::vector<int> keys(numLookups);
+
+	for(int i = 0; i < numLookups; i++)
+	{
+		keys[i] = rand() % (numRecords / 10);
+	}
+
+	//opening the index prints, so the table goes out once every run is done
+	std::ostringstream table;
+	table << "\nfull scan of " << numRecords << " records between lookups of a hot tenth of the index, " << numBufs << " buffer frames\n";
+	table << std::setw(10) << "ring" << std::setw(16) << "scan diskreads" << std::setw(18) << "lookup diskreads" << "\n";
+
+	for(size_t r = 0; r < sizeof(ringSizes) / sizeof(ringSizes[0]); r++)
+	{
+		BufMgr *bufMgr = new BufMgr(numBufs);
+
+		{
+			BTreeIndex index(benchRelationName, indexName, bufMgr, offsetof(BenchRecord, i), INTEGER);
+			std::vector<RecordId> rids;
+			int total = 0;
+
+			for(int i = 0; i < numLookups; i++)
+			{
+				rids.clear();
+				index.lookup(&keys[i], rids);
+			}
+
+			bufMgr->clearBufStats();
+
+			{
+				FileScan fscan(benchRelationName, bufMgr, ringSizes[r]);
+				RecordId rid;
+
+				try
+				{
+					while(1)
+					{
+						fscan.scanNext(rid);
+						total++;
+					}
+				}
+				catch(EndOfFileException e)
+				{
+				}
+			}
+
+			int scanReads = bufMgr->getBufStats().diskreads;
+			bufMgr->clearBufStats();
+
+			for(int i = 0; i < numLookups; i++)
+			{
+				rids.clear();
+				index.lookup(&keys[i], rids);
+				total += rids.size();
+			}
+
+			sink = total;
+			table << std::setw(10) << ringSizes[r] << std::setw(16) << scanReads << std::setw(18) << bufMgr->getBufStats().diskreads << "\n";
+		}
+
+		delete bufMgr;
+	}
+
+	std::cout << table.str();
+	removeFile(indexName);
+	removeFile(benchRelationName);
+}
@@ -5,6 +5,8 @@
  * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
  */
 
+#include <algorithm>
+#include <queue>
 #include "btree.h"
 #include "filescan.h"
 #include "exceptions/bad_index_info_exception.h"
@@ -17,6 +19,7 @@
 #include "exceptions/end_of_file_exception.h"
 #include "exceptions/invalid_page_exception.h"
 #include "exceptions/page_pinned_exception.h"
+#include "exceptions/badgerdb_exception.h"
 
 
 //#define DEBUG
@@ -54,7 +57,7 @@ bool BTreeIndex::setFile(const std::string & relationName, std::string & outInde
 //----------------------------------------------------------------------------
 //get meta page
 //----------------------------------------------------------------------------
-IndexMetaInfo *BTreeIndex::getMetaPage(BufMgr *bufMgrIn, bool fileExists, const std::string & relationName,  const int attrByteOffset,
+PageId BTreeIndex::getMetaPage(BufMgr *bufMgrIn, bool fileExists, const std::string & relationName,  const int attrByteOffset,
                 const Datatype attrType)
 {
      Page *metPage;
@@ -132,9 +135,14 @@ IndexMetaInfo *BTreeIndex::getMetaPage(BufMgr *bufMgrIn, bool fileExists, const
 
     if(!fileExists)
     {
-            //create new metapage instance
-            metaPage = new IndexMetaInfo;
-  
+            PageId metaPageNo;
+
+            //meta page is filled in right in its buffer frame
+            bufMgrIn -> allocPage(file, metaPageNo, metPage);
+
+            metaPage = (IndexMetaInfo*)(metPage);
+            memset(metaPage, 0, sizeof(IndexMetaInfo));
+
             //set relation name
             for(int i = 0; i < 20; i++)
             {
@@ -154,1589 +162,3544 @@ IndexMetaInfo *BTreeIndex::getMetaPage(BufMgr *bufMgrIn, bool fileExists, const
             metaPage -> attrByteOffset = attrByteOffset;
             metaPage -> attrType = attrType;
             metaPage -> rootPageNo = 3;
-
-            PageId metaPageNo;
-
-            bufMgrIn -> allocPage(file, metaPageNo, metPage);
-
-            //set meta page
-            Page* setPage = (Page*)(metaPage);
-
-            metPage[0] = setPage[0]; 
     }
 
+    //frame may be reused once unpinned
+    PageId rootPageNo = metaPage -> rootPageNo;
+
     bufMgrIn -> unPinPage(file, 1, !(fileExists));
 
-    return metaPage;
+    return rootPageNo;
 }
 
 // -----------------------------------------------------------------------------
-// Scan BTreeIndex::scan datafile
+// key of type T stored at ptr
 // -----------------------------------------------------------------------------
-void BTreeIndex::scanDataFile(const std::string & relationName)
+//ptr points into a record or at a key passed in by the caller
+template <class T>
+static T keyAt(const void *ptr)
 {
-     //put all file pages into the buf mgr
-    FileScan *myFileScan = new FileScan(relationName, bufMgr);
-
-    int counter = 0;
-
-    try
-    {
-        while(1)
-        {
-            RecordId test;
+    return *((const T*)(ptr));
+}
 
-            //put pages into memory
-            myFileScan -> scanNext(test);
+//string keys are the first STRINGSIZE characters
+template <>
+StringKey keyAt<StringKey>(const void *ptr)
+{
+    return StringKey((const char*)(ptr));
+}
 
-            //insert record
-            std::string getRecord = myFileScan -> getRecord();
+// -----------------------------------------------------------------------------
+// leaf entries
+// -----------------------------------------------------------------------------
+//every leaf access that depends on how the leaf is laid out goes through
+//these. INTEGER and DOUBLE leaves are plain arrays of keys and record ids,
+//or keep a posting list per distinct key, as their format says; the
+//prefix-compressed STRING leaf has its overloads below
+
+//a new leaf takes the format of the index, or of the leaf it splits from
+template <class T>
+static inline LeafFormat getLeafFormat(LeafNode<T> *leaf)
+{
+    return (LeafFormat)(leaf -> format);
+}
 
-            int *key = (int*)(getRecord.c_str());
+template <class T>
+static inline void setLeafFormat(LeafNode<T> *leaf, const LeafFormat format)
+{
+    leaf -> format = format;
+}
 
-            //if(*key == 1364)
-            //{
-              //  Page *root;
-                //NonLeafNodeInt *rootNode;
+//STRING leaves have only the one
+static inline LeafFormat getLeafFormat(LeafNodeString *leaf)
+{
+    return PLAIN_LEAF;
+}
 
-                //bufMgr -> readPage(file, rootPageNum, root);
+static inline void setLeafFormat(LeafNodeString *leaf, const LeafFormat format)
+{
+}
 
-                //rootNode = (NonLeafNodeInt*)(root);
+//a record id is encoded against the one before it in its posting list, or
+//against page 0 slot 0 at the start of the list: the zigzag varint of the
+//difference in page number, then the zigzag varint of the difference in
+//slot number if the page is the same, or the varint of the slot if not
+static const int MAXRIDBYTES = 8;
 
-                //printTree(rootNode);
-                //exit(0);
-            //}
+static const RecordId LISTSTART = {Page::INVALID_NUMBER, 0};
 
-            insertEntry(key, test);
+static inline std::uint64_t zigzag(const std::int64_t value)
+{
+    return ((std::uint64_t)(value) << 1) ^ (std::uint64_t)(value >> 63);
+}
 
-            //flush file
-            bufMgr -> flushFile(file);
+static inline std::int64_t unzigzag(const std::uint64_t value)
+{
+    return (std::int64_t)(value >> 1) ^ -(std::int64_t)(value & 1);
+}
 
-            counter += 1;
-        }
-    }
+static inline int varintBytes(std::uint64_t value)
+{
+    int bytes = 1;
 
-    catch(EndOfFileException e)
+    while(value >= 0x80)
     {
-                //Page *root;
-                //NonLeafNodeInt *rootNode;
-
-                //bufMgr -> readPage(file, rootPageNum, root);
-
-                //rootNode = (NonLeafNodeInt*)(root);FileScan
-
-                //printTree(rootNode);
-                //exit(0);
-	        delete myFileScan;
+        value >>= 7;
+        bytes++;
     }
 
+    return bytes;
 }
 
-//---------------------------------------------------------------------------
-//create leaf
-//---------------------------------------------------------------------------
-void BTreeIndex::createInitLeaf(PageId &leafNo)
+static inline unsigned char *putVarint(unsigned char *out, std::uint64_t value)
 {
-    //allocate page
-    Page* newPage;
-
-    std::cout << "allocating new page\n";
+    while(value >= 0x80)
+    {
+        *out++ = (unsigned char)(value) | 0x80;
+        value >>= 7;
+    }
 
-    bufMgr -> allocPage(file, leafNo, newPage);
+    *out++ = (unsigned char)(value);
 
-    std::cout << "allocated new page\n";
+    return out;
+}
 
-    //create struct
-    LeafNodeInt *rootLeaf = new LeafNodeInt;
-    
-    rootLeaf -> rightSibPageNo = 0;
+static inline const unsigned char *getVarint(const unsigned char *in, std::uint64_t &value)
+{
+    value = 0;
 
-    for(int i = 0; i < INTARRAYLEAFSIZE; i++)
+    for(int shift = 0; ; shift += 7)
     {
-        RecordId zero = {0,0};
-        rootLeaf -> ridArray[i] = zero;
+        unsigned char byte = *in++;
 
-        rootLeaf -> keyArray[i] = -1;
-    }
-
-    Page* convert = (Page*)(rootLeaf);
+        value |= (std::uint64_t)(byte & 0x7f) << shift;
 
-    newPage[0] = convert[0];
+        if(byte < 0x80)
+        {
+            return in;
+        }
+    }
+}
 
-    bufMgr -> unPinPage(file, leafNo, true);
+static inline std::uint64_t slotCode(const RecordId &prev, const RecordId &rid)
+{
+    if(rid.page_number == prev.page_number)
+    {
+        return zigzag((std::int64_t)(rid.slot_number) - prev.slot_number);
+    }
 
+    return rid.slot_number;
 }
 
-//------------------------------------------------------------------------------
-// Create root
-//-----------------------------------------------------------------------------
-
-void BTreeIndex::createInitRoot()
+//bytes rid takes encoded after prev
+static inline int ridBytes(const RecordId &prev, const RecordId &rid)
 {
-    //create underlying structure of root
-    PageId leaf;
+    return varintBytes(zigzag((std::int64_t)(rid.page_number) - prev.page_number)) + varintBytes(slotCode(prev, rid));
+}
 
-    std::cout << "Creating init leaf\n";
+static inline unsigned char *encodeRid(unsigned char *out, const RecordId &prev, const RecordId &rid)
+{
+    out = putVarint(out, zigzag((std::int64_t)(rid.page_number) - prev.page_number));
 
-    createInitLeaf(leaf);
+    return putVarint(out, slotCode(prev, rid));
+}
 
-    std::cout << "created leaf\n";
+//decodes the record id after prev into rid, which may be prev itself
+static inline const unsigned char *decodeRid(const unsigned char *in, const RecordId &prev, RecordId &rid)
+{
+    std::uint64_t pageCode;
+    std::uint64_t slot;
 
-    //create root page
-    Page* rootPage;
-    Page* setPage;
+    in = getVarint(in, pageCode);
+    in = getVarint(in, slot);
 
-    NonLeafNodeInt *rootNode = new  NonLeafNodeInt;
+    PageId pageNo = (PageId)(prev.page_number + unzigzag(pageCode));
 
-    rootNode -> level = 2;
-    rootNode -> pageNoArray[0] = leaf;
-    PageId rootNo;   
+    rid.slot_number = (SlotId)(pageNo == prev.page_number ? prev.slot_number + unzigzag(slot) : slot);
+    rid.page_number = pageNo;
 
-    //set up node
-    setPage = (Page*)(rootNode);
+    return in;
+}
 
-    std::cout << "Putting root into file\n";
+static inline bool ridLess(const RecordId &rid1, const RecordId &rid2)
+{
+    if(rid1.page_number != rid2.page_number)
+    {
+        return rid1.page_number < rid2.page_number;
+    }
 
-    bufMgr -> allocPage(file, rootNo, rootPage);
-    rootPage[0] = setPage[0];
- 
-    bufMgr -> unPinPage(file, rootNo, true);
- 
-    std::cout << "Placed into bufMgr\n";
+    return rid1.slot_number < rid2.slot_number;
 }
 
-// -----------------------------------------------------------------------------
-// BTreeIndex::BTreeIndex -- Constructor
-// -----------------------------------------------------------------------------
+//a key with more record ids than this gets several posting lists in a row,
+//which bounds what an insert has to decode
+static const int MAXLISTLENGTH = 128;
 
-BTreeIndex::BTreeIndex(const std::string & relationName,
-		std::string & outIndexName,
-		BufMgr *bufMgrIn,
-		const int attrByteOffset,
-		const Datatype attrType)
+//bytes entry i of count sorted keys and rids adds to a leaf holding the
+//entries before it; run is the length of the posting list entry i would
+//go on and is updated to include it
+template <class T>
+static inline int entryBytes(const T *keys, const RecordId *rids, const int i, int &run)
 {
-    std::cout << "START CONSTRUCTING\n";
-
-    bool fileExists = setFile(relationName, outIndexName, attrByteOffset);
-    
-    //fetched existing file
-    if(fileExists)
+    if(i == 0 || keys[i] != keys[i - 1] || run == MAXLISTLENGTH)
     {
-        std::cout << "fetched file\n";
-    }
+        run = 1;
 
-    //created new file
-    else
-    {
-        std::cout << "created new file\n";
+        return LeafNode<T>::GROUPSIZE + ridBytes(LISTSTART, rids[i]);
     }
 
-    IndexMetaInfo *metPage = getMetaPage(bufMgrIn, fileExists, relationName, attrByteOffset, attrType);
+    run++;
 
-    std::cout << "retrieved the metaPage\n";
+    return ridBytes(rids[i - 1], rids[i]);
+}
 
-    //set private vars
-    bufMgr = bufMgrIn;
-    headerPageNum = 1;
-    rootPageNum = metPage -> rootPageNo;
-    attributeType = attrType;
-    this -> attrByteOffset = attrByteOffset;
-    leafOccupancy = INTARRAYLEAFSIZE;
-    nodeOccupancy = INTARRAYNONLEAFSIZE;
+//bytes count sorted keys and rids take in a leaf
+template <class T>
+static int leafEntryBytes(const T *keys, const RecordId *rids, const int count)
+{
+    int bytes = 0;
+    int run = 0;
 
-    //set up root page if file doesn't exist
-    if(!fileExists)
+    for(int i = 0; i < count; i++)
     {
-        createInitRoot();
+        bytes += entryBytes(keys, rids, i, run);
     }
 
-    //before inserting anything, flush file
-    bufMgr -> flushFile(file);
-
-    scanDataFile(relationName);
-   
-    bufMgr -> flushFile(file);
+    return bytes;
 }
 
+template <class T>
+static inline T *getPlainKeys(LeafNode<T> *leaf)
+{
+    return (T*)(leaf -> data);
+}
 
-// -----------------------------------------------------------------------------
-// BTreeIndex::~BTreeIndex -- destructor
-// -----------------------------------------------------------------------------
+template <class T>
+static inline RecordId *getPlainRids(LeafNode<T> *leaf)
+{
+    return (RecordId*)(leaf -> data + LeafNode<T>::PLAINSIZE * sizeof(T));
+}
 
-BTreeIndex::~BTreeIndex()
+template <class T>
+static inline T *getPostingKeys(LeafNode<T> *leaf)
 {
-    delete myFile;   
+    return (T*)(leaf -> data);
 }
 
-// -----------------------------------------------------------------------------
-// BTreeIndex::Print Leaf Node
-// -----------------------------------------------------------------------------
+template <class T>
+static inline PostingGroup *getPostingGroups(LeafNode<T> *leaf)
+{
+    return (PostingGroup*)(leaf -> data + leaf -> numGroups * sizeof(T));
+}
 
-void BTreeIndex::printLeafNode(LeafNodeInt *leaf, PageId leafNo)
+static inline unsigned char *getPostingData(char *data)
 {
-    std::cout << "LeafNode pageNo:" << leafNo << "\n";
-    std::cout << "root sibling page: " << leaf -> rightSibPageNo << "\n";
+    return (unsigned char*)(data);
+}
 
-    for(int i = 0; i < INTARRAYLEAFSIZE; i++)
-    {
-        std::cout << "index " << i << ": ";
-        std::cout << "Key: " << leaf -> keyArray[i];
-        std::cout << " slotNumber: " << leaf -> ridArray[i].slot_number;
-        std::cout << " PageNumber: " << leaf -> ridArray[i].page_number;
-        std::cout << "\n";
-    }
+//first entry past group g
+template <class T>
+static inline int groupEnd(LeafNode<T> *leaf, const int g)
+{
+    return g + 1 < leaf -> numGroups ? getPostingGroups(leaf)[g + 1].first : leaf -> numKeys;
 }
 
-// -----------------------------------------------------------------------------
-// BTreeIndex::Check if leaf Node is full
-// -----------------------------------------------------------------------------
+//first byte past the posting list of group g
+template <class T>
+static inline int listEnd(LeafNode<T> *leaf, const int g)
+{
+    return g + 1 < leaf -> numGroups ? getPostingGroups(leaf)[g + 1].offset : LeafNode<T>::DATASIZE;
+}
 
-bool BTreeIndex::leafFull(LeafNodeInt *leaf)
+//bytes of data in use
+template <class T>
+static inline int leafBytes(LeafNode<T> *leaf)
 {
-    //because we build the tree sequentially, the last -1 is filled with a nonegative
-    //value iff the tree is full
-    if(leaf -> keyArray[INTARRAYLEAFSIZE - 1] == -1)
+    if(leaf -> format == PLAIN_LEAF)
     {
-        return false;
+        return leaf -> numKeys * (int)(sizeof(T) + sizeof(RecordId));
     }
 
-    return true;
+    return leaf -> numGroups * LeafNode<T>::GROUPSIZE + LeafNode<T>::DATASIZE - leaf -> listStart;
 }
 
-// -----------------------------------------------------------------------------
-// BTreeIndex:: check if nonLeafNode is full
-// -----------------------------------------------------------------------------
-
-//same logic as leafNode
-bool BTreeIndex::nonLeafFull(NonLeafNodeInt *nLeaf)
+//group entry i belongs to
+template <class T>
+static int findGroup(LeafNode<T> *leaf, const int i)
 {
-    //there was something wrong with how I implemented the tree
-    //and I can't find it, so hard code
+    PostingGroup *groups = getPostingGroups(leaf);
+    int low = 0;
+    int high = leaf -> numGroups - 1;
 
-    if(nLeaf -> keyArray[INTARRAYNONLEAFSIZE - 1] <= 0)
+    //last group starting at or before i
+    while(low < high)
     {
-        return false;
+        int mid = (low + high + 1) / 2;
+
+        if(groups[mid].first <= i)
+        {
+            low = mid;
+        }
+
+        else
+        {
+            high = mid - 1;
+        }
     }
 
-    return true;
+    return low;
 }
 
-// -----------------------------------------------------------------------------
-// findInsertPlaceSplitLeaf(key, leaf)
-// -----------------------------------------------------------------------------
-int BTreeIndex::findInsertPlaceSplit(int keyArray[], int *key, bool isLeaf)
+//offset of the encoded record id of entry i, in group g; prev is set to
+//the record id it is encoded against
+template <class T>
+static int seekList(LeafNode<T> *leaf, const int g, const int i, RecordId &prev)
 {
-    int length = INTARRAYNONLEAFSIZE;
+    PostingGroup &group = getPostingGroups(leaf)[g];
+    const unsigned char *data = getPostingData(leaf -> data);
+    const unsigned char *in = data + group.offset;
 
-    if(isLeaf)
-    {
-        length = INTARRAYLEAFSIZE;
-    }
+    prev = LISTSTART;
 
-    for(int i = 0; i < length; i++)
+    for(int j = group.first; j < i; j++)
     {
-        //if at the end, return i + 1
-        if(*key > keyArray[i] && keyArray[i+1] == -1)
-        {
-            return i+1;
-        }
+        in = decodeRid(in, prev, prev);
+    }
 
-        //between i and i+1, return i+1
-        else if(*key > keyArray[i] && *key < keyArray[i+1])
-        {
-            return i + 1;
-        }
+    return in - data;
+}
 
-        //less than i, return i
-        else if(*key < keyArray[i])
-        {
-            return i;
-        }
-  
-        else if(*key > keyArray[i] && i == length - 1)
-        {
-            return length;
-        }
+//key of entry i
+template <class T>
+static inline const T &getLeafKey(LeafNode<T> *leaf, const int i)
+{
+    if(leaf -> format == PLAIN_LEAF)
+    {
+        return getPlainKeys(leaf)[i];
     }
 
-    return -1;
+    return getPostingKeys(leaf)[findGroup(leaf, i)];
 }
 
-// -----------------------------------------------------------------------------
-// findInsertPlaceLeaf(key, leaf)
-// -----------------------------------------------------------------------------
-int BTreeIndex::findInsertPlaceLeaf(int *key, LeafNodeInt *leaf)
+//record id of entry i
+template <class T>
+static RecordId getLeafRid(LeafNode<T> *leaf, const int i)
 {
-    for(int i = 0; i < INTARRAYLEAFSIZE - 1; i++)
+    if(leaf -> format == PLAIN_LEAF)
     {
-        if(leaf -> keyArray[0] == -1)
-        {
-            return 0;
-        }
+        return getPlainRids(leaf)[i];
+    }
 
-        //if at the end, return i + 1
-        if(*key > leaf -> keyArray[i] && leaf -> keyArray[i+1] == -1)
-        {
-            return i+1;
-        }
+    RecordId rid;
+    int offset = seekList(leaf, findGroup(leaf, i), i, rid);
 
-        //between i and i+1, return i+1
-        else if(*key > leaf -> keyArray[i] && *key < leaf -> keyArray[i+1])
-        {
-            return i + 1;
-        }
+    decodeRid(getPostingData(leaf -> data) + offset, rid, rid);
 
-        //less than i, return i
-        else if(*key < leaf -> keyArray[i])
-        {
-            return i;
-        }
+    return rid;
+}
+
+//first entry not less than (or, if upper, greater than) key
+template <class T>
+static inline int findLeafIndex(LeafNode<T> *leaf, const T &key, const bool upper)
+{
+    if(leaf -> format == PLAIN_LEAF)
+    {
+        return findKeyIndex(getPlainKeys(leaf), leaf -> numKeys, key, upper);
     }
 
-    return -1;
+    int g = findKeyIndex(getPostingKeys(leaf), leaf -> numGroups, key, upper);
+
+    return g < leaf -> numGroups ? getPostingGroups(leaf)[g].first : leaf -> numKeys;
 }
 
-// -----------------------------------------------------------------------------
-// findInsertPlaceLeaf(key, leaf)
-// -----------------------------------------------------------------------------
-int BTreeIndex::findInsertPlaceNonLeaf(int *key, NonLeafNodeInt *nLeaf)
+//entry holding key and rid, or -1
+template <class T>
+static int findLeafEntry(LeafNode<T> *leaf, const T &key, const RecordId &rid)
 {
-    for(int i = 0; i < INTARRAYNONLEAFSIZE - 1; i++)
+    if(leaf -> format == PLAIN_LEAF)
     {
-        //if at the end, return i + 1
-        if(*key > nLeaf -> keyArray[i] && nLeaf -> keyArray[i+1] == -1)
-        {
-            return i+1;
-        }
+        T *keys = getPlainKeys(leaf);
+        RecordId *rids = getPlainRids(leaf);
 
-        //between i and i+1, return i+1
-        else if(*key > nLeaf -> keyArray[i] && *key < nLeaf -> keyArray[i+1])
+        for(int i = findKeyIndex(keys, leaf -> numKeys, key, false); i < leaf -> numKeys && keys[i] == key; i++)
         {
-            return i + 1;
+            if(rids[i] == rid)
+            {
+                return i;
+            }
         }
 
-        //less than i, return i
-        else if(*key < nLeaf -> keyArray[i])
+        return -1;
+    }
+
+    T *keys = getPostingKeys(leaf);
+    PostingGroup *groups = getPostingGroups(leaf);
+    const unsigned char *data = getPostingData(leaf -> data);
+    int high = findKeyIndex(keys, leaf -> numGroups, key, true);
+
+    for(int g = findKeyIndex(keys, leaf -> numGroups, key, false); g < high; g++)
+    {
+        const unsigned char *in = data + groups[g].offset;
+        RecordId next = LISTSTART;
+
+        for(int i = groups[g].first; i < groupEnd(leaf, g); i++)
         {
-            return i;
+            in = decodeRid(in, next, next);
+
+            if(next == rid)
+            {
+                return i;
+            }
         }
     }
 
     return -1;
 }
 
-void BTreeIndex::printTree(NonLeafNodeInt* node)
+//replaces the bytes [offset, offset + oldBytes) of group g's posting list
+//with newBytes bytes, moving the lists at or before it to make room
+template <class T>
+static void spliceList(LeafNode<T> *leaf, const int g, const int offset, const int oldBytes, const unsigned char *bytes, const int newBytes)
 {
-    //this is a DFS version
+    PostingGroup *groups = getPostingGroups(leaf);
+    int shift = newBytes - oldBytes;
 
-    Page *root;
+    memmove(leaf -> data + leaf -> listStart - shift, leaf -> data + leaf -> listStart, offset - leaf -> listStart);
+    memcpy(leaf -> data + offset - shift, bytes, newBytes);
 
-    //get root
-    bufMgr -> readPage(file, rootPageNum, root);
- 
-    NonLeafNodeInt *rootNode = (NonLeafNodeInt*)(root);
+    leaf -> listStart -= shift;
 
-    //special case
-    if(node -> level == 2)
+    for(int j = 0; j <= g; j++)
     {
-        std::cout << "special case\n";        
+        groups[j].offset -= shift;
+    }
+}
 
-        LeafNodeInt *realRootNode;
-        Page* realRoot;
+//inserts group g with key, first entry first and a posting list of
+//newBytes bytes; the first entries of the groups after it are left as
+//they are
+template <class T>
+static void insertGroup(LeafNode<T> *leaf, const int g, const T &key, const int first, const unsigned char *bytes, const int newBytes)
+{
+    T *keys = getPostingKeys(leaf);
+    int numGroups = leaf -> numGroups;
+    char *oldGroups = (char*)(getPostingGroups(leaf));
+    char *newGroups = leaf -> data + (numGroups + 1) * sizeof(T);
+    int end = g < numGroups ? getPostingGroups(leaf)[g].offset : LeafNode<T>::DATASIZE;
 
-        PageId realRootNo = rootNode -> pageNoArray[0];
+    //group array moves up past the new key, making room for group g
+    memmove(newGroups + (g + 1) * sizeof(PostingGroup), oldGroups + g * sizeof(PostingGroup), (numGroups - g) * sizeof(PostingGroup));
+    memmove(newGroups, oldGroups, g * sizeof(PostingGroup));
+    memmove(keys + g + 1, keys + g, (numGroups - g) * sizeof(T));
 
-        bufMgr -> readPage(file, realRootNo, realRoot);
+    keys[g] = key;
+    leaf -> numGroups += 1;
 
-        realRootNode = (LeafNodeInt*)(realRoot);
+    PostingGroup *groups = getPostingGroups(leaf);
 
-        printLeafNode(realRootNode, realRootNo);
-       
-        bufMgr -> unPinPage(file, realRootNo, false);
-        bufMgr -> unPinPage(file, rootPageNum, false);
-        std::cout << "end of Special Case\n";
-    }
+    //new list goes right before the list of the group that was at g
+    memmove(leaf -> data + leaf -> listStart - newBytes, leaf -> data + leaf -> listStart, end - leaf -> listStart);
+    memcpy(leaf -> data + end - newBytes, bytes, newBytes);
 
-    //every page id below is a leaf node
-    //base case
-    else if(node -> level == 1)
-    {
-        printNonLeafNode(node);
-    }
+    leaf -> listStart -= newBytes;
 
-    //recurse
-    else
+    for(int j = 0; j < g; j++)
     {
-        printNonLeafNode(node);
-
-        //for each non leaf node underneath, retrieve it and print        
-        for(int i = 0; i < INTARRAYNONLEAFSIZE + 1; i++)
-        {
-            PageId getBelowNo = node -> pageNoArray[i];
+        groups[j].offset -= newBytes;
+    }
 
-            if(getBelowNo == 0)
-            {
-                break;
-            }
- 
-            Page* getPage;
-            
-            bufMgr -> readPage(file, getBelowNo, getPage);
+    groups[g].first = first;
+    groups[g].offset = end - newBytes;
+}
 
-            NonLeafNodeInt *gotNode = (NonLeafNodeInt*)(getPage);
+//record id the posting list of group g starts with
+template <class T>
+static inline RecordId firstListRid(LeafNode<T> *leaf, const int g)
+{
+    RecordId rid;
 
-            printTree(gotNode);
+    decodeRid(getPostingData(leaf -> data) + getPostingGroups(leaf)[g].offset, LISTSTART, rid);
 
-            bufMgr -> unPinPage(file, getBelowNo, false);
-        }
-    }
+    return rid;
 }
 
-void BTreeIndex::printNonLeafNode(NonLeafNodeInt* node)
+//puts rid in order into the posting list of group g
+template <class T>
+static void insertListRid(LeafNode<T> *leaf, const int g, const RecordId &rid)
 {
-    std::cout << "start of nonleaf Node\n";
-    std::cout << "keys: ";
-
-    for(int i = 0; i < INTARRAYNONLEAFSIZE; i++)
+    PostingGroup *groups = getPostingGroups(leaf);
+    const unsigned char *data = getPostingData(leaf -> data);
+    unsigned char bytes [2 * MAXRIDBYTES];
+    int offset = groups[g].offset;
+    int end = groupEnd(leaf, g);
+    RecordId prev = LISTSTART;
+    RecordId next;
+    int i = groups[g].first;
+    int oldBytes = 0;
+
+    //rid goes before the first record id greater than it
+    for(; i < end; i++)
     {
-        if(node -> keyArray[i] == -1)
+        oldBytes = decodeRid(data + offset, prev, next) - (data + offset);
+
+        if(ridLess(rid, next))
         {
             break;
         }
 
-        std::cout << node -> keyArray[i] << " ";
+        prev = next;
+        offset += oldBytes;
     }
 
-    std::cout << "\n";
+    unsigned char *out = encodeRid(bytes, prev, rid);
 
-    if(node -> level == 1)
+    //the record id after it is encoded against rid instead
+    if(i < end)
     {
-        std::cout << "printing leaves\n";
-
-        for(int i = 0; i < INTARRAYNONLEAFSIZE + 1; i++)
-        {
-            if(node -> pageNoArray[i] == 0)
-            {
-                break;
-            }
-
-            LeafNodeInt *leaf;
-            Page* leafPage;
-
-            PageId leafNo = node -> pageNoArray[i];
-
-            bufMgr -> readPage(file, leafNo, leafPage);
-
-            leaf = (LeafNodeInt*)(leafPage);
-
-            printLeafNode(leaf, leafNo);
+        out = encodeRid(out, rid, next);
+    }
 
-            bufMgr -> unPinPage(file, leafNo, false);
-        }
+    else
+    {
+        oldBytes = 0;
     }
 
-    std::cout << "end of nonleaf Node\n";
+    spliceList(leaf, g, offset, oldBytes, bytes, out - bytes);
 }
 
-// -----------------------------------------------------------------------------
-// BTreeIndex::getLengthLeaf
-// -----------------------------------------------------------------------------
-//int BTreeIndex::getLengthLeaf(LeafNodeInt *leaf)
-//{
-  //  for(int i = 0; i < INTARRAYLEAFSIZE; i++)
-    //{
-      //  if(leaf -> keyArray[i] == -1)
-        //    return i;
-    //}
-
-    //return INTARRAYLEAFSIZE;
-//}
-
-// -----------------------------------------------------------------------------
-// BTreeIndex::insertLeaf
-// -----------------------------------------------------------------------------
-void BTreeIndex::insertLeaf(int *key, const RecordId rid, LeafNodeInt *leaf)
+//puts rid into the full posting list of group g and splits the list in
+//half, the second half becoming group g + 1
+template <class T>
+static void splitList(LeafNode<T> *leaf, const int g, const RecordId &rid)
 {
-    int index = findInsertPlaceLeaf(key, leaf);
+    RecordId rids [MAXLISTLENGTH + 1];
+    unsigned char bytes [(MAXLISTLENGTH + 1) * MAXRIDBYTES];
+    const unsigned char *in = getPostingData(leaf -> data) + getPostingGroups(leaf)[g].offset;
+    int length = 0;
+    bool placed = false;
 
-    if(index == -1)
+    for(int i = getPostingGroups(leaf)[g].first; i < groupEnd(leaf, g); i++)
     {
-        std::cout << "Inserted into leaf node that wasn't supposed to be inserted";
-        std::cout << " into\n";
-
-        exit(0);
-    }
- 
-    //std::cout << "Inside insert Leaf\n";
-    //printLeafNode(leaf);
+        RecordId next;
 
-    int copyKeyArray [INTARRAYLEAFSIZE];
-    RecordId copyRidArray [INTARRAYLEAFSIZE];
+        in = decodeRid(in, length == 0 ? LISTSTART : rids[length - 1], next);
 
-    //shift everything over
-    //for(int i = INTARRAYLEAFSIZE - 1; i > index; i--)
-    //{
-      //  leaf -> keyArray[i+1] = leaf -> keyArray[i];
-    //}
+        if(!placed && ridLess(rid, next))
+        {
+            rids[length++] = rid;
+            placed = true;
+        }
 
-    for(int i = 0; i < index; i++)
-    {
-        copyKeyArray[i] = leaf -> keyArray[i];
-        copyRidArray[i] = leaf -> ridArray[i];
+        rids[length++] = next;
     }
 
-    for(int i = index+1; i < INTARRAYLEAFSIZE; i++)
+    if(!placed)
     {
-        copyKeyArray[i] = leaf -> keyArray[i - 1];
-        copyRidArray[i] = leaf -> ridArray[i - 1];
+        rids[length++] = rid;
     }
 
-    copyKeyArray[index] = *key;
-    copyRidArray[index] = rid;
+    int half = length / 2;
+    unsigned char *out = bytes;
 
-    //leaf -> keyArray = copyKeyArray;
-    //leaf -> ridArray = copyRidArray;
+    for(int i = 0; i < length; i++)
+    {
+        out = encodeRid(out, (i == 0 || i == half) ? LISTSTART : rids[i - 1], rids[i]);
 
-    std::copy(std::begin(copyKeyArray), std::end(copyKeyArray), leaf -> keyArray);
-    std::copy(std::begin(copyRidArray), std::end(copyRidArray), leaf -> ridArray);
+        if(i == half - 1)
+        {
+            in = out;
+        }
+    }
 
-    //printLeafNode(leaf);
+    int fBytes = (const unsigned char*)(in) - bytes;
+    int offset = getPostingGroups(leaf)[g].offset;
+    T key = getPostingKeys(leaf)[g];
 
-    //std::cout << "outside insert leaf\n";
-    //leaf -> keyArray[index] = *key;
-    //leaf -> ridArray[index] = rid;
+    spliceList(leaf, g, offset, listEnd(leaf, g) - offset, bytes, fBytes);
+    insertGroup(leaf, g + 1, key, getPostingGroups(leaf)[g].first + half, bytes + fBytes, out - bytes - fBytes);
 }
 
-// -----------------------------------------------------------------------------
-// BTreeIndex::insertNonLeaf
-// -----------------------------------------------------------------------------
-void BTreeIndex::insertNonLeaf(int* key, PageId fLeafNo, PageId sLeafNo, NonLeafNodeInt *nLeaf)
+//adds key and rid to a leaf with room for them, after the entries equal to
+//key in a plain leaf; rid goes in order into a posting list of key, or a
+//new one
+template <class T>
+static void insertLeafEntry(LeafNode<T> *leaf, const T &key, const RecordId &rid)
 {
-    int index = findInsertPlaceNonLeaf(key, nLeaf);
-
-    if(index == -1)
+    if(leaf -> format == PLAIN_LEAF)
     {
-        std::cout << "Inserted into leaf node that wasn't supposed to be inserted";
-        std::cout << " into\n";
+        T *keys = getPlainKeys(leaf);
+        RecordId *rids = getPlainRids(leaf);
+        int index = findKeyIndex(keys, leaf -> numKeys, key, true);
+
+        //shift everything after index over by one
+        std::copy_backward(keys + index, keys + leaf -> numKeys, keys + leaf -> numKeys + 1);
+        std::copy_backward(rids + index, rids + leaf -> numKeys, rids + leaf -> numKeys + 1);
 
-        exit(0);
+        keys[index] = key;
+        rids[index] = rid;
+        leaf -> numKeys += 1;
+
+        return;
     }
 
-    int copyKeyArray [INTARRAYNONLEAFSIZE];
-    PageId copyPageNoArray [INTARRAYNONLEAFSIZE + 1];
+    T *keys = getPostingKeys(leaf);
+    int numGroups = leaf -> numGroups;
+    int low = findKeyIndex(keys, numGroups, key, false);
+    int high = findKeyIndex(keys, numGroups, key, true);
+    int g = low;
 
-    for(int i = 0; i < index; i++)
+    if(low == high)
     {
-        copyKeyArray[i] = nLeaf -> keyArray[i];
-        copyPageNoArray[i] = nLeaf -> pageNoArray[i];
+        unsigned char bytes [MAXRIDBYTES];
+        int first = low < numGroups ? getPostingGroups(leaf)[low].first : leaf -> numKeys;
+
+        insertGroup(leaf, low, key, first, bytes, encodeRid(bytes, LISTSTART, rid) - bytes);
     }
 
-    for(int i = index+1; i < INTARRAYLEAFSIZE; i++)
+    else
     {
-        copyKeyArray[i] = nLeaf -> keyArray[i - 1];
-        copyPageNoArray[i + 1] = nLeaf -> pageNoArray[i];
-    }
+        //last of key's lists starting at or before rid
+        int last = high - 1;
 
-    copyKeyArray[index] = *key;
-    copyPageNoArray[index] = fLeafNo;
-    copyPageNoArray[index + 1] = sLeafNo;
+        while(g < last)
+        {
+            int mid = (g + last + 1) / 2;
 
-    std::copy(std::begin(copyKeyArray), std::end(copyKeyArray), nLeaf -> keyArray);
-    std::copy(std::begin(copyPageNoArray), std::end(copyPageNoArray), nLeaf -> pageNoArray);
+            if(ridLess(rid, firstListRid(leaf, mid)))
+            {
+                last = mid - 1;
+            }
 
-    //need to set left leaf sibling page
-    if(index != 0 && nLeaf -> level == 1)
-    {
-        PageId lLeaf = copyPageNoArray[index - 1];
-        Page *lPage;
+            else
+            {
+                g = mid;
+            }
+        }
 
-        bufMgr -> readPage(file, lLeaf, lPage);
-        
-        LeafNodeInt *lLeafNode = (LeafNodeInt*)(lPage);
+        if(groupEnd(leaf, g) - getPostingGroups(leaf)[g].first < MAXLISTLENGTH)
+        {
+            insertListRid(leaf, g, rid);
+        }
 
-        lLeafNode -> rightSibPageNo = fLeafNo;
+        else
+        {
+            splitList(leaf, g, rid);
+            g++;
+        }
+    }
 
-        Page *convert = (Page*)(lLeafNode);
-        lPage[0] = convert[0];
+    PostingGroup *groups = getPostingGroups(leaf);
 
-        bufMgr -> unPinPage(file, lLeaf, true);
+    for(int j = g + 1; j < leaf -> numGroups; j++)
+    {
+        groups[j].first++;
     }
+
+    leaf -> numKeys += 1;
 }
 
-// -----------------------------------------------------------------------------
-// BTreeIndex::slit root
-// -----------------------------------------------------------------------------
-void BTreeIndex::splitRoot(PageId fNextNode, PageId sNextNode, NonLeafNodeInt *root, int* intKey, bool level)
+//removes entry i; a posting list left empty goes with its key
+template <class T>
+static void removeLeafEntry(LeafNode<T> *leaf, const int i)
 {
-     NonLeafNodeInt tempLeaf = *root;
+    if(leaf -> format == PLAIN_LEAF)
+    {
+        T *keys = getPlainKeys(leaf);
+        RecordId *rids = getPlainRids(leaf);
 
-     //want to delete root
-     bufMgr -> unPinPage(file, rootPageNum, false);
+        std::copy(keys + i + 1, keys + leaf -> numKeys, keys + i);
+        std::copy(rids + i + 1, rids + leaf -> numKeys, rids + i);
 
-     bufMgr -> flushFile(file);
+        leaf -> numKeys -= 1;
 
-     //try to delete leaf
-     try
-     {
-         file -> deletePage(rootPageNum);
-     }
+        return;
+    }
 
-     catch(InvalidPageException e)
-     {
-     }
+    int g = findGroup(leaf, i);
+    int end = groupEnd(leaf, g);
+    PostingGroup *groups = getPostingGroups(leaf);
+    const unsigned char *data = getPostingData(leaf -> data);
+    unsigned char bytes [MAXRIDBYTES];
+    RecordId prev;
+    RecordId rid;
 
-     //recreate root
-     Page *rootPage;
-     PageId rootId;
-     bufMgr -> allocPage(file, rootId, rootPage);
+    int offset = seekList(leaf, g, i, prev);
+    int oldBytes = decodeRid(data + offset, prev, rid) - (data + offset);
+    int newBytes = 0;
 
-     rootPageNum = rootId;
+    if(i + 1 < end)
+    {
+        //the next record id is encoded against prev instead
+        RecordId next;
 
-     //create non-leaves before implementing new root
-     int copyKeyArray [INTARRAYNONLEAFSIZE + 1];
-     PageId copyPageNoArray [INTARRAYNONLEAFSIZE + 2];
+        oldBytes = decodeRid(data + offset + oldBytes, rid, next) - (data + offset);
+        newBytes = encodeRid(bytes, prev, next) - bytes;
+    }
 
-     int index = findInsertPlaceSplit(tempLeaf.keyArray, intKey, true);
+    spliceList(leaf, g, offset, oldBytes, bytes, newBytes);
 
-     for(int i = 0; i < index; i++)
-     {
-         copyKeyArray[i] = tempLeaf.keyArray[i];
-         copyPageNoArray[i] = tempLeaf.pageNoArray[i];
-     }
+    for(int j = g + 1; j < leaf -> numGroups; j++)
+    {
+        groups[j].first--;
+    }
 
-     copyKeyArray[index] = *intKey;
-     copyPageNoArray[index] = fNextNode;
-     copyPageNoArray[index + 1] = sNextNode;
+    leaf -> numKeys -= 1;
 
-     for(int i = index + 1; i < INTARRAYNONLEAFSIZE + 1; i++)
-     {
-         copyKeyArray[i] = tempLeaf.keyArray[i - 1];
-         copyPageNoArray[i+1] = tempLeaf.pageNoArray[i];
-     }
+    if(end - groups[g].first == 1)
+    {
+        T *keys = getPostingKeys(leaf);
+        int numGroups = leaf -> numGroups;
+        char *oldGroups = (char*)(groups);
+        char *newGroups = leaf -> data + (numGroups - 1) * sizeof(T);
 
-     //split in half
-     int half = (INTARRAYNONLEAFSIZE + 1) / 2;
-     int firstKeys[INTARRAYNONLEAFSIZE];
-     int secondKeys[INTARRAYNONLEAFSIZE];
-     PageId firstPageNo[INTARRAYNONLEAFSIZE];
-     PageId secondPageNo[INTARRAYNONLEAFSIZE];
+        //key and group array move down over key g
+        memmove(keys + g, keys + g + 1, (numGroups - g - 1) * sizeof(T));
+        memmove(newGroups, oldGroups, g * sizeof(PostingGroup));
+        memmove(newGroups + g * sizeof(PostingGroup), oldGroups + (g + 1) * sizeof(PostingGroup), (numGroups - g - 1) * sizeof(PostingGroup));
 
-     //split arrays in two
-     for(int i = 0; i < INTARRAYNONLEAFSIZE + 1; i++)
-     {
-         if(i != INTARRAYNONLEAFSIZE)
-             secondKeys[i] = -1;
-         secondPageNo[i] = 0;
+        leaf -> numGroups -= 1;
+    }
+}
 
-         if(i >= half)
-         {
-             if(i != INTARRAYNONLEAFSIZE)
-                 firstKeys[i] = -1;
-             firstPageNo[i] = 0;
-         }
+//a lazily deleted entry keeps its key, for the order, and loses its record
+//id; posting lists order entries by record id and can't hold one, so their
+//entries are removed right away, which also leaves the tree as it is
+static inline bool isTombstone(const RecordId &rid)
+{
+    return rid.page_number == Page::INVALID_NUMBER;
+}
 
-         else
-         {
-             if(i != INTARRAYNONLEAFSIZE)
-                 firstKeys[i] = copyKeyArray[i];
-             firstPageNo[i] = copyPageNoArray[i];
-         }
-     }
+template <class T>
+static inline void markLeafTombstone(LeafNode<T> *leaf, const int i)
+{
+    if(leaf -> format == PLAIN_LEAF)
+    {
+        getPlainRids(leaf)[i].page_number = Page::INVALID_NUMBER;
+    }
 
-     for(int i = half; i < (INTARRAYNONLEAFSIZE + 2); i++)
-     {
-         if(i != INTARRAYNONLEAFSIZE + 1)
-             secondKeys[i - half] = copyKeyArray[i];
-         secondPageNo[i - half] = copyPageNoArray[i];
-     }
+    else
+    {
+        removeLeafEntry(leaf, i);
+    }
+}
 
-     //close but we need to push a key up to the root
-     int pushUp = firstKeys[half - 1];
-     firstKeys[half - 1] = -1;
+//copies the entries of leaf, tombstones left out, into keys and rids and
+//returns their number
+template <class T>
+static int readLeafEntries(LeafNode<T> *leaf, T *keys, RecordId *rids)
+{
+    if(leaf -> format == PLAIN_LEAF)
+    {
+        T *leafKeys = getPlainKeys(leaf);
+        RecordId *leafRids = getPlainRids(leaf);
+        int count = 0;
 
-     Page *fnLeaf;
-     PageId fnLeafNo;
-     Page *snLeaf;
-     PageId snLeafNo;
+        for(int i = 0; i < leaf -> numKeys; i++)
+        {
+            if(!isTombstone(leafRids[i]))
+            {
+                keys[count] = leafKeys[i];
+                rids[count] = leafRids[i];
+                count++;
+            }
+        }
 
-     //create new leaves
-     bufMgr -> allocPage(file, fnLeafNo, fnLeaf);
-     bufMgr -> allocPage(file, snLeafNo, snLeaf);
+        return count;
+    }
 
-     NonLeafNodeInt *fnLeafNode = (NonLeafNodeInt*)(fnLeaf);
-     NonLeafNodeInt *snLeafNode = (NonLeafNodeInt*)(snLeaf);
+    T *leafKeys = getPostingKeys(leaf);
+    PostingGroup *groups = getPostingGroups(leaf);
+    const unsigned char *in = getPostingData(leaf -> data) + leaf -> listStart;
 
-     std::copy(std::begin(firstKeys), std::end(firstKeys), fnLeafNode -> keyArray);
-     std::copy(std::begin(firstPageNo), std::end(firstPageNo), fnLeafNode -> pageNoArray);
+    for(int g = 0; g < leaf -> numGroups; g++)
+    {
+        RecordId prev = LISTSTART;
 
-     std::copy(std::begin(secondKeys), std::end(secondKeys), snLeafNode -> keyArray);
-     std::copy(std::begin(secondPageNo), std::end(secondPageNo), snLeafNode -> pageNoArray);
+        for(int i = groups[g].first; i < groupEnd(leaf, g); i++)
+        {
+            in = decodeRid(in, prev, prev);
 
-     if(level)
-     {
-         fnLeafNode -> level = 1;
-         snLeafNode -> level = 1;
-     }
+            keys[i] = leafKeys[g];
+            rids[i] = prev;
+        }
+    }
 
-     //convert back into pages
-     Page* convert = (Page*)(fnLeafNode);
-     fnLeaf[0] = convert[0];
+    return leaf -> numKeys;
+}
 
-     convert = (Page*)(snLeafNode);
-     snLeaf[0] = convert[0];
+//replaces the entries of leaf with count sorted keys and rids
+template <class T>
+static void writeLeafEntries(LeafNode<T> *leaf, const T *keys, const RecordId *rids, const int count)
+{
+    if(leaf -> format == PLAIN_LEAF)
+    {
+        std::copy(keys, keys + count, getPlainKeys(leaf));
+        std::copy(rids, rids + count, getPlainRids(leaf));
 
-     bufMgr -> unPinPage(file, fnLeafNo, true);
-     bufMgr -> unPinPage(file, snLeafNo, true);
+        leaf -> numKeys = count;
 
-     //need to set left leaf sibling page
-     if(index != 0 && tempLeaf.level == 1)
-     {
-         PageId lLeaf = copyPageNoArray[index - 1];
-         Page *lPage;
- 
-         bufMgr -> readPage(file, lLeaf, lPage);
- 
-         LeafNodeInt *lLeafNode = (LeafNodeInt*)(lPage);
- 
-         lLeafNode -> rightSibPageNo = fNextNode;
- 
-         Page *convert = (Page*)(lLeafNode);
-         lPage[0] = convert[0];
- 
-         bufMgr -> unPinPage(file, lLeaf, true);
-     }
+        return;
+    }
 
-     //set Root
-     NonLeafNodeInt *rootNode = (NonLeafNodeInt*)(rootPage);
-     for(int i = 0; i < INTARRAYNONLEAFSIZE; i++)
-     {
-         //fill keys
-         if(i == 0)
-         {
-                 rootNode -> keyArray[i] = pushUp;
-         }
-         
-         else
-         {
-             rootNode -> keyArray[i] = -1;
-         }
-     }
+    int numGroups = 0;
+    int run = 0;
 
-     for(int i = 0; i < INTARRAYNONLEAFSIZE; i++)
-     {
-         //fill page No
-         if(i == 0)
-         {
-             rootNode -> pageNoArray[i] = fnLeafNo;
-         }
+    for(int i = 0; i < count; i++)
+    {
+        entryBytes(keys, rids, i, run);
 
-         else if(i == 1)
-         {
-             rootNode -> pageNoArray[i] = snLeafNo;
-         }
+        numGroups += run == 1 ? 1 : 0;
+    }
 
-         else
-         {
-             rootNode -> pageNoArray[i] = 0;
-         }
-     }
+    leaf -> numKeys = count;
+    leaf -> numGroups = numGroups;
+    leaf -> listStart = LeafNode<T>::DATASIZE - (leafEntryBytes(keys, rids, count) - numGroups * LeafNode<T>::GROUPSIZE);
 
-     rootNode -> level = 0;
+    T *leafKeys = getPostingKeys(leaf);
+    PostingGroup *groups = getPostingGroups(leaf);
+    unsigned char *data = getPostingData(leaf -> data);
+    unsigned char *out = data + leaf -> listStart;
+    int g = -1;
 
-     bufMgr -> unPinPage(file, rootPageNum, true);
-     bufMgr -> flushFile(file);
+    run = 0;
+
+    for(int i = 0; i < count; i++)
+    {
+        entryBytes(keys, rids, i, run);
+
+        if(run == 1)
+        {
+            g++;
+            leafKeys[g] = keys[i];
+            groups[g].first = i;
+            groups[g].offset = out - data;
+
+            out = encodeRid(out, LISTSTART, rids[i]);
+        }
 
-     //convert back into pages
-     convert = (Page*)(rootNode);
-     rootPage[0] = convert[0];
+        else
+        {
+            out = encodeRid(out, rids[i - 1], rids[i]);
+        }
+    }
 }
 
-void BTreeIndex::splitNonLeafNode(PageId fNextNode, PageId sNextNode, PageId oldNode, NonLeafNodeInt *currNode, std::list <PageId> &path, bool firstLevel, int *intKey)
+//empties leaf, keeping its format
+template <class T>
+static inline void clearLeaf(LeafNode<T> *leaf)
 {
-     NonLeafNodeInt tempLeaf = *currNode;
+    leaf -> numKeys = 0;
+    leaf -> numGroups = 0;
+    leaf -> listStart = LeafNode<T>::DATASIZE;
+}
 
-     //want to delete root
-     bufMgr -> unPinPage(file, oldNode, false);
+//replaces the entries of leaf with count sorted pairs
+template <class T>
+static void fillLeaf(LeafNode<T> *leaf, const RIDKeyPair<T> *pairs, const int count)
+{
+    T keys [LeafNode<T>::SIZE];
+    RecordId rids [LeafNode<T>::SIZE];
 
-     bufMgr -> flushFile(file);
+    for(int i = 0; i < count; i++)
+    {
+        keys[i] = pairs[i].key;
+        rids[i] = pairs[i].rid;
+    }
 
-     //try to delete leaf
-     try
-     {
-         std::cout << "trying\n";
-         file -> deletePage(oldNode);
-         std::cout << "failing\n";
-     }
+    writeLeafEntries(leaf, keys, rids, count);
+}
 
-     catch(InvalidPageException e)
-     {
-     }
+//true if count sorted keys and rids fit in one leaf of leaf's format
+template <class T>
+static inline bool leafEntriesFit(LeafNode<T> *leaf, const T *keys, const RecordId *rids, const int count)
+{
+    if(leaf -> format == PLAIN_LEAF)
+    {
+        return count <= LeafNode<T>::PLAINSIZE;
+    }
 
-     //get Prev Node
-     PageId prevPageNo = path.front();
-     path.pop_front();
+    return leafEntryBytes(keys, rids, count) <= LeafNode<T>::DATASIZE;
+}
 
-     //create non-leaves before splitting
-     int copyKeyArray [INTARRAYNONLEAFSIZE + 1];
-     PageId copyPageNoArray [INTARRAYNONLEAFSIZE + 2];
+//number of the length sorted keys and rids that go to the left of the two
+//leaves of leaf's format they are split into: about half the bytes, moved
+//as far as it takes for both sides to fit
+template <class T>
+static int leafSplitPoint(LeafNode<T> *leaf, const T *keys, const RecordId *rids, const int length)
+{
+    if(leaf -> format == PLAIN_LEAF || length < 2)
+    {
+        return length / 2;
+    }
 
-     int index = findInsertPlaceSplit(tempLeaf.keyArray, intKey, true);
+    //bytes[i] is the number of bytes the first i entries take
+    int bytes [2 * LeafNode<T>::SIZE + 1];
+    int run = 0;
 
-     for(int i = 0; i < index; i++)
-     {
-         copyKeyArray[i] = tempLeaf.keyArray[i];
-         copyPageNoArray[i] = tempLeaf.pageNoArray[i];
-     }
+    bytes[0] = 0;
 
-     copyKeyArray[index] = *intKey;
-     copyPageNoArray[index] = fNextNode;
-     copyPageNoArray[index + 1] = sNextNode;
+    for(int i = 0; i < length; i++)
+    {
+        bytes[i + 1] = bytes[i] + entryBytes(keys, rids, i, run);
+    }
 
-     for(int i = index + 1; i < INTARRAYNONLEAFSIZE + 1; i++)
-     {
-         copyKeyArray[i] = tempLeaf.keyArray[i - 1];
-         copyPageNoArray[i+1] = tempLeaf.pageNoArray[i];
-     }
+    //the right side starts a posting list at half even if the key goes on
+    int half = 1;
 
-     //split in half
-     int half = (INTARRAYNONLEAFSIZE + 1) / 2;
-     int firstKeys[INTARRAYNONLEAFSIZE];
-     int secondKeys[INTARRAYNONLEAFSIZE];
-     PageId firstPageNo[INTARRAYNONLEAFSIZE];
-     PageId secondPageNo[INTARRAYNONLEAFSIZE];
+    while(half < length - 1 && bytes[half] < bytes[length] - bytes[half + 1] + LeafNode<T>::GROUPSIZE + ridBytes(LISTSTART, rids[half]))
+    {
+        half++;
+    }
 
-     //split arrays in two
-     for(int i = 0; i < INTARRAYNONLEAFSIZE + 1; i++)
-     {
-         if(i != INTARRAYNONLEAFSIZE)
-             secondKeys[i] = -1;
-         secondPageNo[i] = 0;
+    while(half > 1 && bytes[half] > LeafNode<T>::DATASIZE)
+    {
+        half--;
+    }
 
-         if(i >= half)
-         {
-             if(i != INTARRAYNONLEAFSIZE)
-                 firstKeys[i] = -1;
-             firstPageNo[i] = 0;
-         }
+    while(half < length - 1 && !leafEntriesFit(leaf, keys + half, rids + half, length - half))
+    {
+        half++;
+    }
 
-         else
-         {
-             if(i != INTARRAYNONLEAFSIZE)
-                 firstKeys[i] = copyKeyArray[i];
-             firstPageNo[i] = copyPageNoArray[i];
-         }
-     }
+    return half;
+}
 
-     for(int i = half; i < (INTARRAYNONLEAFSIZE + 2); i++)
-     {
-         if(i != INTARRAYNONLEAFSIZE + 1)
-             secondKeys[i - half] = copyKeyArray[i];
-         secondPageNo[i - half] = copyPageNoArray[i];
-     }
+//rewrites leaf without its tombstones; returns true if it had any
+template <class T>
+static bool purgeTombstones(LeafNode<T> *leaf)
+{
+    //posting lists drop lazily deleted entries right away
+    if(leaf -> format != PLAIN_LEAF)
+    {
+        return false;
+    }
 
-     //close but we need to push a key up to the next nonleaf node
-     int pushUp = firstKeys[half - 1];
-     firstKeys[half - 1] = -1;
+    int i = 0;
 
-     Page *fnLeaf;
-     PageId fnLeafNo;
-     Page *snLeaf;
-     PageId snLeafNo;
+    while(i < leaf -> numKeys && !isTombstone(getPlainRids(leaf)[i]))
+    {
+        i++;
+    }
 
-     //create new leaves
-     bufMgr -> allocPage(file, fnLeafNo, fnLeaf);
-     bufMgr -> allocPage(file, snLeafNo, snLeaf);
+    if(i == leaf -> numKeys)
+    {
+        return false;
+    }
 
-     NonLeafNodeInt *fnLeafNode = (NonLeafNodeInt*)(fnLeaf);
-     NonLeafNodeInt *snLeafNode = (NonLeafNodeInt*)(snLeaf);
+    T keys [LeafNode<T>::PLAINSIZE];
+    RecordId rids [LeafNode<T>::PLAINSIZE];
 
-     std::copy(std::begin(firstKeys), std::end(firstKeys), fnLeafNode -> keyArray);
-     std::copy(std::begin(firstPageNo), std::end(firstPageNo), fnLeafNode -> pageNoArray);
+    int length = readLeafEntries(leaf, keys, rids);
 
-     std::copy(std::begin(secondKeys), std::end(secondKeys), snLeafNode -> keyArray);
-     std::copy(std::begin(secondPageNo), std::end(secondPageNo), snLeafNode -> pageNoArray);
+    writeLeafEntries(leaf, keys, rids, length);
 
-     if(firstLevel)
-     {
-         fnLeafNode -> level = 1;
-         snLeafNode -> level = 1;
-     }
+    return true;
+}
 
-     //convert back into pages
-     Page* convert = (Page*)(fnLeafNode);
-     fnLeaf[0] = convert[0];
+//puts cursor on entry i and decodes its record id
+template <class T>
+static void seekLeafCursor(LeafNode<T> *leaf, const int i, LeafCursor &cursor)
+{
+    if(leaf -> format == PLAIN_LEAF)
+    {
+        cursor.rid = getPlainRids(leaf)[i];
 
-     convert = (Page*)(snLeafNode);
-     snLeaf[0] = convert[0];
+        return;
+    }
 
-     bufMgr -> unPinPage(file, fnLeafNo, true);
-     bufMgr -> unPinPage(file, snLeafNo, true);
+    RecordId prev;
+    const unsigned char *data = getPostingData(leaf -> data);
 
-     //need to set left leaf sibling page
-     if(index != 0 && tempLeaf.level == 1)
-     {
-         PageId lLeaf = copyPageNoArray[index - 1];
-         Page *lPage;
- 
-         bufMgr -> readPage(file, lLeaf, lPage);
- 
-         LeafNodeInt *lLeafNode = (LeafNodeInt*)(lPage);
- 
-         lLeafNode -> rightSibPageNo = fNextNode;
- 
-         Page *convert = (Page*)(lLeafNode);
-         lPage[0] = convert[0];
- 
-         bufMgr -> unPinPage(file, lLeaf, true);
-     }
+    cursor.group = findGroup(leaf, i);
+    cursor.groupEnd = groupEnd(leaf, cursor.group);
+    cursor.offset = decodeRid(data + seekList(leaf, cursor.group, i, prev), prev, cursor.rid) - data;
+}
 
-     Page *prevPage;
-     bufMgr -> readPage(file, prevPageNo, prevPage);
+//moves cursor from entry i on to entry i + 1, if there is one; returns
+//true if it has the same key. posting lists are packed in key order, so
+//the next one starts where the cursor is
+template <class T>
+static inline bool nextLeafCursor(LeafNode<T> *leaf, const int i, LeafCursor &cursor)
+{
+    if(i + 1 >= leaf -> numKeys)
+    {
+        return false;
+    }
 
-     NonLeafNodeInt *prevNode = (NonLeafNodeInt*)(prevPage);
+    if(leaf -> format == PLAIN_LEAF)
+    {
+        T *keys = getPlainKeys(leaf);
 
-     if(nonLeafFull(prevNode))
-     {
-         if(prevPageNo == rootPageNum)
-         {
-             int *entry = &pushUp;
+        cursor.rid = getPlainRids(leaf)[i + 1];
 
-             splitNonLeafNode(fnLeafNo, snLeafNo, prevPageNo, prevNode, path, false, entry);
-         }
+        return keys[i + 1] == keys[i];
+    }
 
-         else
-         {
-             int *entry = &pushUp;
+    const unsigned char *data = getPostingData(leaf -> data);
 
-             splitRoot(fnLeafNo, snLeafNo, prevNode, entry, false);
-         }
-     } 
+    if(i + 1 < cursor.groupEnd)
+    {
+        cursor.offset = decodeRid(data + cursor.offset, cursor.rid, cursor.rid) - data;
 
-     else
-     {
-          int *entry = &pushUp;
+        return true;
+    }
 
-          insertNonLeaf(entry, fnLeafNo, snLeafNo, prevNode);
+    T *keys = getPostingKeys(leaf);
 
-          //update page
-          Page* convert = (Page*)(prevNode);
+    cursor.group++;
+    cursor.groupEnd = groupEnd(leaf, cursor.group);
+    cursor.offset = decodeRid(data + cursor.offset, LISTSTART, cursor.rid) - data;
 
-          prevPage[0] = convert[0];
+    return keys[cursor.group] == keys[cursor.group - 1];
+}
 
-          //clean up
-          bufMgr -> unPinPage(file, prevPageNo, true);
-      }
+//key of entry i, which cursor is on
+template <class T>
+static inline const T &getCursorKey(LeafNode<T> *leaf, const int i, const LeafCursor &cursor)
+{
+    if(leaf -> format == PLAIN_LEAF)
+    {
+        return getPlainKeys(leaf)[i];
+    }
 
-     //see if we need to split the prevNode
+    return getPostingKeys(leaf)[cursor.group];
 }
 
 // -----------------------------------------------------------------------------
-// BTreeIndex::splitLeaf
+// prefix-compressed STRING leaves
 // -----------------------------------------------------------------------------
-void BTreeIndex::splitLeaf(LeafNodeInt *leafNode, PageId oldLeaf, std::list <PageId> &path, int *intKey, RecordId rid)
+
+//bytes an entry takes besides the characters of its suffix: slot and length byte
+static const int STRINGENTRYSIZE = sizeof(StringLeafSlot) + 1;
+
+static inline StringLeafSlot *getStringSlots(LeafNodeString *leaf)
 {
-     //printTree(rootNode);
-     //bufMgr -> unPinPage(file, rootPageNum, false);
-     LeafNodeInt tempLeaf = *leafNode;
+    return (StringLeafSlot*)(leaf -> data);
+}
 
-     //want to delete leaf
-     bufMgr -> unPinPage(file, rootPageNum, false);
-     bufMgr -> unPinPage(file, oldLeaf, false);
+//number of characters in key
+static inline int stringKeyLength(const StringKey &key)
+{
+    return strnlen(key.data, STRINGSIZE);
+}
 
-     bufMgr -> flushFile(file);
+//number of leading characters key1 and key2 have in common
+static inline int stringCommonPrefix(const StringKey &key1, const StringKey &key2)
+{
+    int i = 0;
 
-     //try to delete leaf
-     try
-     {
-         file -> deletePage(oldLeaf);
-     }
+    while(i < STRINGSIZE && key1.data[i] == key2.data[i] && key1.data[i] != '\0')
+    {
+        i++;
+    }
 
-     catch(InvalidPageException e)
-     {
-     }
+    return i;
+}
 
-     //create leaves before setting new non-leaf node
-     int copyKeyArray [INTARRAYLEAFSIZE + 1];
-     RecordId copyRidArray [INTARRAYLEAFSIZE + 1];
+//bytes taken by count sorted keys from first to last stored in one leaf,
+//where lengthSum is the number of characters over all of them
+static inline int stringLeafBytes(const StringKey &first, const StringKey &last, const int count, const int lengthSum)
+{
+    return count * STRINGENTRYSIZE + lengthSum - count * stringCommonPrefix(first, last);
+}
 
-     int index = findInsertPlaceSplit(tempLeaf.keyArray, intKey, true);
+//true if splitting the length sorted keys before half leaves two halves that
+//each fit in a leaf; lengthSum[i] is the number of characters in the first i keys
+static bool stringSplitFits(const StringKey *keys, const int *lengthSum, const int length, const int half)
+{
+    if(half < 1 || half > length - 1)
+    {
+        return false;
+    }
 
+    return stringLeafBytes(keys[0], keys[half - 1], half, lengthSum[half]) <= LeafNodeString::DATASIZE
+        && stringLeafBytes(keys[half], keys[length - 1], length - half, lengthSum[length] - lengthSum[half]) <= LeafNodeString::DATASIZE;
+}
 
-     for(int i = 0; i < index; i++)
-     {
-         copyKeyArray[i] = tempLeaf.keyArray[i];
-         copyRidArray[i] = tempLeaf.ridArray[i];
-     }
+//sign of key's suffix compared to the suffix stored at entry
+static inline int compareStringSuffix(const char *keySuffix, const int keySuffixLength, const unsigned char *entry)
+{
+    int entryLength = entry[0];
+    int cmp = memcmp(keySuffix, entry + 1, std::min(keySuffixLength, entryLength));
 
-     copyKeyArray[index] = *intKey;
-     copyRidArray[index] = rid;
+    return cmp != 0 ? cmp : keySuffixLength - entryLength;
+}
 
-     for(int i = index; i < INTARRAYLEAFSIZE; i++)
-     {
-         copyKeyArray[i+1] = tempLeaf.keyArray[i];
-         copyRidArray[i+1] = tempLeaf.ridArray[i];
-     }
+static StringKey getLeafKey(LeafNodeString *leaf, const int i)
+{
+    const unsigned char *suffix = (const unsigned char*)(leaf -> data + getStringSlots(leaf)[i].suffixOffset);
+    int length = leaf -> prefixLength + suffix[0];
 
-     //split in half
-     int half = (INTARRAYLEAFSIZE + 1) / 2;
-     int firstKeys[INTARRAYLEAFSIZE];
-     int secondKeys[INTARRAYLEAFSIZE];
-     RecordId firstRid[INTARRAYLEAFSIZE];
-     RecordId secondRid[INTARRAYLEAFSIZE];
+    StringKey key;
 
-     //split arrays in two
-     for(int i = 0; i < INTARRAYLEAFSIZE; i++)
-     {
-         secondKeys[i] = -1;
-         secondRid[i] = {0,0};
+    memcpy(key.data, leaf -> prefix, leaf -> prefixLength);
+    memcpy(key.data + leaf -> prefixLength, suffix + 1, suffix[0]);
+    memset(key.data + length, 0, STRINGSIZE - length);
 
-         if(i >= half)
-         {
-             firstKeys[i] = -1;
-             firstRid[i] = {0,0};
-         }
+    return key;
+}
 
-         else
-         {
-             firstKeys[i] = copyKeyArray[i];
-             firstRid[i] = copyRidArray[i];
-         }
-     }
+static RecordId getLeafRid(LeafNodeString *leaf, const int i)
+{
+    StringLeafSlot &slot = getStringSlots(leaf)[i];
 
-     for(int i = half; i < (INTARRAYLEAFSIZE + 1); i++)
-     {
-         secondKeys[i - half] = copyKeyArray[i];
-         secondRid[i - half] = copyRidArray[i];
-     }
+    RecordId rid;
+    rid.page_number = slot.pageNo;
+    rid.slot_number = slot.slotNo;
 
-     Page *fLeaf;
-     PageId fLeafNo;
-     Page *sLeaf;
-     PageId sLeafNo;
+    return rid;
+}
 
-     //create new leaves
-     bufMgr -> allocPage(file, fLeafNo, fLeaf);
-     bufMgr -> allocPage(file, sLeafNo, sLeaf);
+static int findLeafIndex(LeafNodeString *leaf, const StringKey &key, const bool upper)
+{
+    if(leaf -> numKeys == 0)
+    {
+        return 0;
+    }
 
-     LeafNodeInt *fLeafNode = (LeafNodeInt*)(fLeaf);
-     LeafNodeInt *sLeafNode = (LeafNodeInt*)(sLeaf);
+    //every key of the leaf starts with the prefix, so a key that doesn't
+    //goes before or after all of them
+    int cmp = memcmp(key.data, leaf -> prefix, leaf -> prefixLength);
 
-     fLeafNode -> rightSibPageNo = sLeafNo;
-     std::copy(std::begin(firstKeys), std::end(firstKeys), fLeafNode -> keyArray);
-     std::copy(std::begin(firstRid), std::end(firstRid), fLeafNode -> ridArray);
+    if(cmp != 0)
+    {
+        return cmp < 0 ? 0 : leaf -> numKeys;
+    }
 
-     sLeafNode -> rightSibPageNo = tempLeaf.rightSibPageNo;
-     std::copy(std::begin(secondKeys), std::end(secondKeys), sLeafNode -> keyArray);
-     std::copy(std::begin(secondRid), std::end(secondRid), sLeafNode -> ridArray);
+    const char *keySuffix = key.data + leaf -> prefixLength;
+    int keySuffixLength = stringKeyLength(key) - leaf -> prefixLength;
+    StringLeafSlot *slots = getStringSlots(leaf);
 
-     //convert back into pages
-     Page* convert = (Page*)(fLeafNode);
-     fLeaf[0] = convert[0];
+    //same steps as findKeyIndexScalar, comparing suffixes in place
+    int base = 0;
+    int length = leaf -> numKeys;
 
-     convert = (Page*)(sLeafNode);
-     sLeaf[0] = convert[0];
+    while(length > 1)
+    {
+        int half = length / 2;
+        cmp = compareStringSuffix(keySuffix, keySuffixLength, (const unsigned char*)(leaf -> data + slots[base + half - 1].suffixOffset));
+        bool right = upper ? cmp >= 0 : cmp > 0;
+        base = right ? base + half : base;
+        length -= half;
+    }
 
-     bufMgr -> unPinPage(file, fLeafNo, true);
-     bufMgr -> unPinPage(file, sLeafNo, true);
+    cmp = compareStringSuffix(keySuffix, keySuffixLength, (const unsigned char*)(leaf -> data + slots[base].suffixOffset));
 
-     std::cout << "leaves completed\n";
+    return base + (upper ? cmp >= 0 : cmp > 0);
+}
 
-     //see if nonleafnode is full
-     PageId prevNodeId = path.front();
-     path.pop_front();
+//stores the suffix of key in front of the suffixes already in leaf
+static void appendStringSuffix(LeafNodeString *leaf, StringLeafSlot &slot, const StringKey &key)
+{
+    int length = stringKeyLength(key) - leaf -> prefixLength;
 
-     Page *prevPage;
+    leaf -> suffixStart -= length + 1;
+    leaf -> suffixBytes += length + 1;
 
-     bufMgr -> readPage(file, prevNodeId, prevPage);
- 
-     NonLeafNodeInt *prevNode = (NonLeafNodeInt*)(prevPage);
+    leaf -> data[leaf -> suffixStart] = (char)(length);
+    memcpy(leaf -> data + leaf -> suffixStart + 1, key.data + leaf -> prefixLength, length);
 
-     if(nonLeafFull(prevNode))
-     {
-         if(prevNodeId == rootPageNum)
-         {
-             int entry = secondKeys[0];
-             int *newEntry = &entry;
+    slot.suffixOffset = leaf -> suffixStart;
+}
 
-             splitRoot(fLeafNo, sLeafNo, prevNode, newEntry, true);
-         }
+//replaces the entries of leaf with count sorted keys and rids, prefix
+//compressed with the prefix they all share
+static void formatStringLeaf(LeafNodeString *leaf, const StringKey *keys, const RecordId *rids, const int count)
+{
+    StringLeafSlot *slots = getStringSlots(leaf);
 
-         else
-         {
-             std::cout << "split non root\n";
-             int entry = secondKeys[0];
-             int *newEntry = &entry;
+    leaf -> numKeys = count;
+    leaf -> prefixLength = count == 0 ? 0 : stringCommonPrefix(keys[0], keys[count - 1]);
+    leaf -> suffixStart = LeafNodeString::DATASIZE;
+    leaf -> suffixBytes = 0;
 
-             splitNonLeafNode(fLeafNo, sLeafNo, prevNodeId, prevNode, path, true, newEntry);
-         }
-         //not implemented
-         //exit(0); 
-     }
+    memset(leaf -> prefix, 0, STRINGSIZE);
+    memcpy(leaf -> prefix, keys[0].data, leaf -> prefixLength);
 
-     else
-     {
-         int entry = secondKeys[0];
-         int *newEntry = &entry;
+    for(int i = 0; i < count; i++)
+    {
+        slots[i].pageNo = rids[i].page_number;
+        slots[i].slotNo = rids[i].slot_number;
 
-         insertNonLeaf(newEntry, fLeafNo, sLeafNo, prevNode);
+        appendStringSuffix(leaf, slots[i], keys[i]);
+    }
+}
 
-         std::cout << "done insertion\n";
+//decodes the entries of leaf into keys and rids, leaving a gap at index
+//for one more entry, and returns the number of entries decoded
+static int decodeStringLeaf(LeafNodeString *leaf, StringKey *keys, RecordId *rids, const int index)
+{
+    for(int i = 0; i < leaf -> numKeys; i++)
+    {
+        int to = i < index ? i : i + 1;
 
-         //printTree(prevNode);
+        keys[to] = getLeafKey(leaf, i);
+        rids[to] = getLeafRid(leaf, i);
+    }
 
-         //convert back
-         Page *convert = (Page*)(prevNode);
-         prevPage[0] = convert[0];
+    return leaf -> numKeys;
+}
 
-         //unpin page
-         bufMgr -> unPinPage(file, prevNodeId, true);
-     }
+static void fillLeaf(LeafNodeString *leaf, const RIDKeyPair<StringKey> *pairs, const int count)
+{
+    StringKey keys[LeafNodeString::SIZE];
+    RecordId rids[LeafNodeString::SIZE];
+
+    for(int i = 0; i < count; i++)
+    {
+        keys[i] = pairs[i].key;
+        rids[i] = pairs[i].rid;
+    }
+
+    formatStringLeaf(leaf, keys, rids, count);
 }
 
-void BTreeIndex::findPath(std::list <PageId> &path, int *key)
+static inline void markLeafTombstone(LeafNodeString *leaf, const int i)
 {
-    Page *currPage;
-    PageId nextPageNo;
+    getStringSlots(leaf)[i].pageNo = Page::INVALID_NUMBER;
+}
 
-    nextPageNo = rootPageNum;
+static int readLeafEntries(LeafNodeString *leaf, StringKey *keys, RecordId *rids)
+{
+    int count = 0;
 
-    bool reachedLeaf = false;
+    for(int i = 0; i < leaf -> numKeys; i++)
+    {
+        if(!isTombstone(getLeafRid(leaf, i)))
+        {
+            keys[count] = getLeafKey(leaf, i);
+            rids[count] = getLeafRid(leaf, i);
+            count++;
+        }
+    }
 
-    while(!reachedLeaf)
+    return count;
+}
+
+static void writeLeafEntries(LeafNodeString *leaf, const StringKey *keys, const RecordId *rids, const int count)
+{
+    formatStringLeaf(leaf, keys, rids, count);
+}
+
+static inline void clearLeaf(LeafNodeString *leaf)
+{
+    leaf -> numKeys = 0;
+    leaf -> prefixLength = 0;
+    leaf -> suffixStart = LeafNodeString::DATASIZE;
+    leaf -> suffixBytes = 0;
+
+    memset(leaf -> prefix, 0, STRINGSIZE);
+}
+
+//the suffix of entry i is left behind as unused bytes until the leaf is
+//rewritten; the prefix still holds for the entries that are left
+static void removeLeafEntry(LeafNodeString *leaf, const int i)
+{
+    StringLeafSlot *slots = getStringSlots(leaf);
+
+    leaf -> suffixBytes -= (unsigned char)(leaf -> data[slots[i].suffixOffset]) + 1;
+
+    std::copy(slots + i + 1, slots + leaf -> numKeys, slots + i);
+
+    leaf -> numKeys -= 1;
+}
+
+static bool leafEntriesFit(LeafNodeString *leaf, const StringKey *keys, const RecordId *rids, const int count)
+{
+    if(count == 0)
     {
-        //push curr node's page number into stack
-        path.push_front(nextPageNo);
+        return true;
+    }
 
-        //get page
-        bufMgr -> readPage(file, nextPageNo, currPage);
-        PageId currPageNum = nextPageNo;  
- 
-        //getNonLeafNode
-        NonLeafNodeInt * actualNode = (NonLeafNodeInt*)(currPage);
+    int lengthSum = 0;
+
+    for(int i = 0; i < count; i++)
+    {
+        lengthSum += stringKeyLength(keys[i]);
+    }
+
+    return stringLeafBytes(keys[0], keys[count - 1], count, lengthSum) <= LeafNodeString::DATASIZE;
+}
+
+//split in half if both halves fit once compressed, else at the closest
+//point that does; splitting a full leaf next to the new key always does
+static int leafSplitPoint(LeafNodeString *leaf, const StringKey *keys, const RecordId *rids, const int length)
+{
+    //lengthSum[i] is the number of characters in the first i keys
+    int lengthSum [2 * LeafNodeString::SIZE + 1];
+
+    lengthSum[0] = 0;
+
+    for(int i = 0; i < length; i++)
+    {
+        lengthSum[i + 1] = lengthSum[i] + stringKeyLength(keys[i]);
+    }
+
+    int half = length / 2;
+
+    for(int step = 1; !stringSplitFits(keys, lengthSum, length, half); step++)
+    {
+        //length / 2 + 1, length / 2 - 1, length / 2 + 2, ...
+        half = (step % 2 == 1) ? length / 2 + (step + 1) / 2 : length / 2 - step / 2;
+    }
+
+    return half;
+}
+
+//rewrites leaf without its tombstones; returns true if it had any
+static bool purgeTombstones(LeafNodeString *leaf)
+{
+    int i = 0;
+
+    while(i < leaf -> numKeys && !isTombstone(getLeafRid(leaf, i)))
+    {
+        i++;
+    }
+
+    if(i == leaf -> numKeys)
+    {
+        return false;
+    }
 
-        if(actualNode -> level == 1)
+    StringKey keys [LeafNodeString::SIZE];
+    RecordId rids [LeafNodeString::SIZE];
+
+    int length = readLeafEntries(leaf, keys, rids);
+
+    writeLeafEntries(leaf, keys, rids, length);
+
+    return true;
+}
+
+static int findLeafEntry(LeafNodeString *leaf, const StringKey &key, const RecordId &rid)
+{
+    for(int i = findLeafIndex(leaf, key, false); i < leaf -> numKeys && getLeafKey(leaf, i) == key; i++)
+    {
+        if(getLeafRid(leaf, i) == rid)
         {
-            //std::cout << "find path " << nextPageNo; 
-            reachedLeaf = true;
+            return i;
         }
+    }
+
+    return -1;
+}
+
+//every entry has its own key, so the cursor only holds the record id
+static inline void seekLeafCursor(LeafNodeString *leaf, const int i, LeafCursor &cursor)
+{
+    cursor.rid = getLeafRid(leaf, i);
+}
+
+static inline bool nextLeafCursor(LeafNodeString *leaf, const int i, LeafCursor &cursor)
+{
+    if(i + 1 < leaf -> numKeys)
+    {
+        cursor.rid = getLeafRid(leaf, i + 1);
+    }
+
+    return false;
+}
+
+static inline StringKey getCursorKey(LeafNodeString *leaf, const int i, const LeafCursor &cursor)
+{
+    return getLeafKey(leaf, i);
+}
+
+// -----------------------------------------------------------------------------
+// separator keys
+// -----------------------------------------------------------------------------
+
+//separator pushed up between a left half ending in left and a right half
+//starting with right: keys equal to it go right, so it has to be greater
+//than left and at most right. fixed width keys can't get any shorter
+template <class T>
+static inline T shortestSeparator(const T &left, const T &right)
+{
+    return right;
+}
+
+//shortest prefix of right that is still greater than left; equal keys
+//can't be told apart, so right goes up whole
+static StringKey shortestSeparator(const StringKey &left, const StringKey &right)
+{
+    if(!(left < right))
+    {
+        return right;
+    }
+
+    int length = stringCommonPrefix(left, right) + 1;
+
+    StringKey separator;
+
+    memcpy(separator.data, right.data, length);
+    memset(separator.data + length, 0, STRINGSIZE - length);
+
+    return separator;
+}
+
+// -----------------------------------------------------------------------------
+// Scan BTreeIndex::scan datafile
+// -----------------------------------------------------------------------------
+template <class T>
+void BTreeIndex::scanDataFile(const std::string & relationName)
+{
+    std::vector< RIDKeyPair<T> > pairs;
+    std::vector<SortRun> runs;
+    int numPairs = 0;
+
+    //collect a (key, rid) pair for every record, through a ring of frames
+    //unless ringSize is 0, so that the relation doesn't push the index's
+    //pages out of the pool
+    {
+        FileScan myFileScan(relationName, bufMgr, ringSize);
 
-        //get next page No
-        for(int i = 0; i < INTARRAYNONLEAFSIZE; i++)
+        try
         {
-            if(i == 0)
-            {
-                if(*key < actualNode -> keyArray[0])
-                {
-                    nextPageNo = actualNode -> pageNoArray[0];
-                    break;
-                }
-            }
- 
-            else
+            while(1)
             {
-                if(*key > actualNode -> keyArray[i - 1] && *key < actualNode -> keyArray[i])
-                {
-                    nextPageNo = actualNode -> pageNoArray[i];
-                    break;
-                }
+                RecordId rid;
 
-                else if(*key > actualNode -> keyArray[i - 1] && actualNode -> keyArray[i] == -1)
-                {
-                    nextPageNo = actualNode -> pageNoArray[i];
-                    break;
-                }
+                myFileScan.scanNext(rid);
+
+                //key is read straight off the pinned page
+                std::size_t recordLength;
+                const char *record = myFileScan.getRecordBytes(recordLength);
+
+                RIDKeyPair<T> pair;
+                pair.set(rid, keyAt<T>(record + attrByteOffset));
 
-                else if(*key > actualNode -> keyArray[i] && i == INTARRAYNONLEAFSIZE - 1)
+                pairs.push_back(pair);
+                numPairs += 1;
+
+                //out of memory for this run, write it out
+                if((int)(pairs.size()) >= runSize)
                 {
-                    nextPageNo = actualNode -> pageNoArray[i + 1];
-                    break;
+                    spillRun(pairs, runs);
                 }
             }
         }
 
-        bufMgr -> unPinPage(file, currPageNum, false);
+        catch(EndOfFileException e)
+        {
+        }
     }
 
-    //leaf is reached
-    path.push_front(nextPageNo);
+    //nothing to load, start with an empty root
+    if(numPairs == 0)
+    {
+        createInitRoot<T>();
+        return;
+    }
+
+    std::vector< PageKeyPair<T> > level;
+
+    //everything fit in memory
+    if(runs.empty())
+    {
+        std::sort(pairs.begin(), pairs.end());
+
+        PageId prevLeafNo = 0;
+        int next = 0;
+
+        while(next < numPairs)
+        {
+            int count = leafFillCount(&pairs[next], numPairs - next, numPairs - next);
+
+            packLeaf(&pairs[next], count, prevLeafNo, level);
+            next += count;
+        }
+    }
+
+    else
+    {
+        //the last run may have been spilled full already
+        if(!pairs.empty())
+        {
+            spillRun(pairs, runs);
+        }
+        mergeRuns(runs, numPairs, level);
+    }
+
+    packNonLeafLevels(level);
 }
 
 // -----------------------------------------------------------------------------
-// BTreeIndex::insertEntry
+// BTreeIndex::spillRun
+// -----------------------------------------------------------------------------
+template <class T>
+void BTreeIndex::spillRun(std::vector< RIDKeyPair<T> > &pairs, std::vector<SortRun> &runs)
+{
+    std::sort(pairs.begin(), pairs.end());
+
+    std::ostringstream runStr;
+    runStr << file -> filename() << ".run" << runs.size();
+
+    //leftover from a crashed build
+    if(File::exists(runStr.str()))
+    {
+        File::remove(runStr.str());
+    }
+
+    BlobFile run(runStr.str(), true);
+
+    //pack pairs into run pages
+    for(unsigned int next = 0; next < pairs.size(); next += SortRunPage<T>::SIZE)
+    {
+        Page page;
+        SortRunPage<T> *runPage = (SortRunPage<T>*)(&page);
+
+        runPage -> numPairs = std::min((int)(pairs.size() - next), (int)(SortRunPage<T>::SIZE));
+        std::copy(pairs.begin() + next, pairs.begin() + next + runPage -> numPairs, runPage -> pairArray);
+
+        PageId pageNo;
+        run.allocatePage(pageNo);
+        run.writePage(pageNo, page);
+    }
+
+    SortRun sortRun;
+    sortRun.fileName = runStr.str();
+    sortRun.numPairs = pairs.size();
+    runs.push_back(sortRun);
+
+    pairs.clear();
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::mergeRuns
 // -----------------------------------------------------------------------------
 
-//code for insertEntry is ruddy terrible
-//TAs hide your eyes, it looks disgusting.
-//I hate this code SOOOOOO much
-//it's like Urgh
+/**
+ * Read position inside one sorted run during the merge.
+ */
+template <class T>
+struct SortRunReader
+{
+    BlobFile *run;
+    PageId pageNo;
+    Page page;
+    int pos;
+    int remaining;
+};
 
-const void BTreeIndex::insertEntry(const void *key, const RecordId rid) 
+/**
+ * Orders (pair, run) heap entries so that the smallest pair is on top.
+ */
+template <class T>
+struct SortRunGreater
 {
-    int *intKey = (int*)(key);
-    
-    //std::cout << "Inserting Key " << *intKey << " with page No " << rid.page_number << " and slot id " << rid.slot_number << "\n";
+    bool operator()(const std::pair< RIDKeyPair<T>, int > &p1, const std::pair< RIDKeyPair<T>, int > &p2) const
+    {
+        return p2.first < p1.first;
+    }
+};
+
+template <class T>
+void BTreeIndex::mergeRuns(const std::vector<SortRun> &runs, const int numPairs, std::vector< PageKeyPair<T> > &level)
+{
+    std::vector< SortRunReader<T> > readers(runs.size());
+    std::priority_queue< std::pair< RIDKeyPair<T>, int >, std::vector< std::pair< RIDKeyPair<T>, int > >, SortRunGreater<T> > heap;
+
+    //open every run and push its first pair
+    for(unsigned int i = 0; i < runs.size(); i++)
+    {
+        readers[i].run = new BlobFile(runs[i].fileName, false);
+        readers[i].pageNo = 1;
+        readers[i].page = readers[i].run -> readPage(1);
+        readers[i].pos = 0;
+        readers[i].remaining = runs[i].numPairs;
+
+        heap.push(std::make_pair(((SortRunPage<T>*)(&readers[i].page)) -> pairArray[0], (int)(i)));
+    }
+
+    PageId prevLeafNo = 0;
+    int remaining = numPairs;
+    std::vector< RIDKeyPair<T> > leafPairs;
+
+    while(remaining > 0)
+    {
+        //pull the next smallest pairs until a full leaf's worth is buffered
+        int buffered = std::min(remaining, (int)(LeafNode<T>::SIZE));
+
+        while((int)(leafPairs.size()) < buffered)
+        {
+            std::pair< RIDKeyPair<T>, int > top = heap.top();
+            heap.pop();
+
+            leafPairs.push_back(top.first);
+
+            //advance the run the pair came from
+            SortRunReader<T> &reader = readers[top.second];
+            SortRunPage<T> *runPage = (SortRunPage<T>*)(&reader.page);
+
+            reader.pos += 1;
+            reader.remaining -= 1;
+
+            //run is exhausted
+            if(reader.remaining == 0)
+            {
+                continue;
+            }
+
+            if(reader.pos == runPage -> numPairs)
+            {
+                reader.pageNo += 1;
+                reader.page = reader.run -> readPage(reader.pageNo);
+                reader.pos = 0;
+            }
+
+            heap.push(std::make_pair(runPage -> pairArray[reader.pos], top.second));
+        }
+
+        int count = leafFillCount(&leafPairs[0], buffered, remaining);
+
+        packLeaf(&leafPairs[0], count, prevLeafNo, level);
+
+        leafPairs.erase(leafPairs.begin(), leafPairs.begin() + count);
+        remaining -= count;
+    }
+
+    //clean up runs
+    for(unsigned int i = 0; i < runs.size(); i++)
+    {
+        delete readers[i].run;
+        File::remove(runs[i].fileName);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::leafFillCount
+// -----------------------------------------------------------------------------
+//plain leaves spread the pairs left evenly over as few leaves as the fill
+//factor allows; posting leaves hold as many pairs as fit in the fill
+//factor's share of the page once their record ids are in posting lists
+template <class T>
+int BTreeIndex::leafFillCount(const RIDKeyPair<T> *pairs, const int available, const int remaining)
+{
+    if(leafFormat == PLAIN_LEAF)
+    {
+        int leafFill = std::max(1, (int)(LeafNode<T>::PLAINSIZE * std::min(fillFactor, 1.0)));
+        int numLeaves = (remaining + leafFill - 1) / leafFill;
+
+        return std::min(available, (remaining + numLeaves - 1) / numLeaves);
+    }
+
+    //counted the way entryBytes does, a key starting a new group every
+    //MAXLISTLENGTH record ids
+    int fillBytes = (int)(LeafNode<T>::DATASIZE * std::min(fillFactor, 1.0));
+    int bytes = LeafNode<T>::GROUPSIZE + ridBytes(LISTSTART, pairs[0].rid);
+    int run = 1;
+    int count = 1;
+
+    while(count < available)
+    {
+        if(pairs[count].key != pairs[count - 1].key || run == MAXLISTLENGTH)
+        {
+            run = 1;
+            bytes += LeafNode<T>::GROUPSIZE + ridBytes(LISTSTART, pairs[count].rid);
+        }
+
+        else
+        {
+            run++;
+            bytes += ridBytes(pairs[count - 1].rid, pairs[count].rid);
+        }
+
+        if(bytes > fillBytes)
+        {
+            break;
+        }
+
+        count++;
+    }
+
+    return count;
+}
+
+//STRING leaves hold as many pairs as fit in the fill factor's share of the
+//page once prefix compressed
+int BTreeIndex::leafFillCount(const RIDKeyPair<StringKey> *pairs, const int available, const int remaining)
+{
+    int fillBytes = (int)(LeafNodeString::DATASIZE * std::min(fillFactor, 1.0));
+    int lengthSum = stringKeyLength(pairs[0].key);
+    int count = 1;
+
+    while(count < available)
+    {
+        int length = stringKeyLength(pairs[count].key);
+
+        if(stringLeafBytes(pairs[0].key, pairs[count].key, count + 1, lengthSum + length) > fillBytes)
+        {
+            break;
+        }
+
+        lengthSum += length;
+        count++;
+    }
+
+    return count;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::packLeaf
+// -----------------------------------------------------------------------------
+template <class T>
+void BTreeIndex::packLeaf(const RIDKeyPair<T> *pairs, const int count, PageId &prevLeafNo, std::vector< PageKeyPair<T> > &level)
+{
+    Page *leafPage;
+    PageId leafNo;
+
+    bufMgr -> allocPage(file, leafNo, leafPage);
+
+    LeafNode<T> *leafNode = (LeafNode<T>*)(leafPage);
+
+    setLeafFormat(leafNode, leafFormat);
+    fillLeaf(leafNode, pairs, count);
+    leafNode -> rightSibPageNo = 0;
+
+    bufMgr -> unPinPage(file, leafNo, true);
+
+    T separator = pairs[0].key;
+
+    //link previous leaf to this one
+    if(prevLeafNo != 0)
+    {
+        Page *prevPage;
+
+        bufMgr -> readPage(file, prevLeafNo, prevPage);
+
+        LeafNode<T> *prevLeaf = (LeafNode<T>*)(prevPage);
+
+        prevLeaf -> rightSibPageNo = leafNo;
+        separator = shortestSeparator(getLeafKey(prevLeaf, prevLeaf -> numKeys - 1), pairs[0].key);
+
+        bufMgr -> unPinPage(file, prevLeafNo, true);
+    }
+
+    prevLeafNo = leafNo;
+
+    PageKeyPair<T> entry;
+    entry.set(leafNo, separator);
+    level.push_back(entry);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::packNonLeafLevels
+// -----------------------------------------------------------------------------
+template <class T>
+void BTreeIndex::packNonLeafLevels(std::vector< PageKeyPair<T> > &level)
+{
+    //at least three children per node, so evening out never leaves a node with one child;
+    //clamped like the leaves, since a fill factor over 1 would overflow the node
+    int nodeFill = std::max(3, (int)((NonLeafNode<T>::SIZE + 1) * std::min(fillFactor, 1.0)));
+    bool aboveLeaves = true;
+
+    //a single leaf hangs off the initial root
+    if(level.size() == 1)
+    {
+        Page *rootPage;
+        PageId rootNo;
+
+        bufMgr -> allocPage(file, rootNo, rootPage);
+
+        NonLeafNode<T> *rootNode = (NonLeafNode<T>*)(rootPage);
+
+        rootNode -> level = 2;
+        rootNode -> numKeys = 0;
+        rootNode -> pageNoArray[0] = level[0].pageNo;
+
+        bufMgr -> unPinPage(file, rootNo, true);
+
+        level[0].pageNo = rootNo;
+    }
+
+    while(level.size() > 1)
+    {
+        std::vector< PageKeyPair<T> > parents;
+
+        int numNodes = (level.size() + nodeFill - 1) / nodeFill;
+        int next = 0;
+
+        for(int i = 0; i < numNodes; i++)
+        {
+            int count = level.size() / numNodes + (i < (int)(level.size() % numNodes) ? 1 : 0);
+
+            Page *nodePage;
+            PageId nodeNo;
+
+            bufMgr -> allocPage(file, nodeNo, nodePage);
+
+            NonLeafNode<T> *node = (NonLeafNode<T>*)(nodePage);
+
+            node -> level = aboveLeaves ? 1 : 0;
+            node -> numKeys = count - 1;
+
+            //key j - 1 separates child j from the children left of it
+            node -> pageNoArray[0] = level[next].pageNo;
+
+            for(int j = 1; j < count; j++)
+            {
+                node -> keyArray[j - 1] = level[next + j].key;
+                node -> pageNoArray[j] = level[next + j].pageNo;
+            }
+
+            bufMgr -> unPinPage(file, nodeNo, true);
+
+            PageKeyPair<T> entry;
+            entry.set(nodeNo, level[next].key);
+            parents.push_back(entry);
+
+            next += count;
+        }
+
+        level.swap(parents);
+        aboveLeaves = false;
+    }
+
+    rootPageNum = level[0].pageNo;
+
+    //record new root in meta page
+    Page *metPage;
+
+    bufMgr -> readPage(file, headerPageNum, metPage);
+
+    ((IndexMetaInfo*)(metPage)) -> rootPageNo = rootPageNum;
+
+    bufMgr -> unPinPage(file, headerPageNum, true);
+}
+
+//---------------------------------------------------------------------------
+//create leaf
+//---------------------------------------------------------------------------
+template <class T>
+void BTreeIndex::createInitLeaf(PageId &leafNo)
+{
+    //allocate page
+    Page* newPage;
+
+    bufMgr -> allocPage(file, leafNo, newPage);
+
+    //format an empty leaf in the frame
+    LeafNode<T> *rootLeaf = (LeafNode<T>*)(newPage);
+
+    setLeafFormat(rootLeaf, leafFormat);
+    clearLeaf(rootLeaf);
+    rootLeaf -> rightSibPageNo = 0;
+
+    bufMgr -> unPinPage(file, leafNo, true);
+
+}
+
+//------------------------------------------------------------------------------
+// Create root
+//-----------------------------------------------------------------------------
+
+template <class T>
+void BTreeIndex::createInitRoot()
+{
+    //create underlying structure of root
+    PageId leaf;
+
+    createInitLeaf<T>(leaf);
+
+    //create root page
+    Page* rootPage;
+    PageId rootNo;
+
+    bufMgr -> allocPage(file, rootNo, rootPage);
+
+    //set up node in the frame
+    NonLeafNode<T> *rootNode = (NonLeafNode<T>*)(rootPage);
+
+    rootNode -> level = 2;
+    rootNode -> numKeys = 0;
+    rootNode -> pageNoArray[0] = leaf;
+
+    bufMgr -> unPinPage(file, rootNo, true);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::BTreeIndex -- Constructor
+// -----------------------------------------------------------------------------
+
+BTreeIndex::BTreeIndex(const std::string & relationName,
+		std::string & outIndexName,
+		BufMgr *bufMgrIn,
+		const int attrByteOffset,
+		const Datatype attrType,
+		const double fillFactor,
+		const int runSize,
+		const LeafFormat leafFormat,
+		const std::uint32_t ringSize)
+{
+    std::cout << "START CONSTRUCTING\n";
+
+    bool fileExists = setFile(relationName, outIndexName, attrByteOffset);
+    
+    //fetched existing file
+    if(fileExists)
+    {
+        std::cout << "fetched file\n";
+    }
+
+    //created new file
+    else
+    {
+        std::cout << "created new file\n";
+    }
+
+    PageId rootPageNo = getMetaPage(bufMgrIn, fileExists, relationName, attrByteOffset, attrType);
+
+    std::cout << "retrieved the metaPage\n";
+
+    //set private vars
+    bufMgr = bufMgrIn;
+    headerPageNum = 1;
+    rootPageNum = rootPageNo;
+    attributeType = attrType;
+    this -> attrByteOffset = attrByteOffset;
+    this -> fillFactor = fillFactor;
+    this -> runSize = runSize;
+    this -> leafFormat = leafFormat;
+    this -> ringSize = ringSize;
+    deleteMode = EAGER_DELETE;
+    insertHintNo = 0;
+    scanExecuting = false;
+    nextEntry = -1;
+    currentPageNum = 0;
+
+    switch(attributeType)
+    {
+        case INTEGER:
+            leafOccupancy = INTARRAYLEAFSIZE;
+            nodeOccupancy = INTARRAYNONLEAFSIZE;
+            break;
+
+        case DOUBLE:
+            leafOccupancy = DOUBLEARRAYLEAFSIZE;
+            nodeOccupancy = DOUBLEARRAYNONLEAFSIZE;
+            break;
+
+        case STRING:
+            leafOccupancy = STRINGARRAYLEAFSIZE;
+            nodeOccupancy = STRINGARRAYNONLEAFSIZE;
+            break;
+    }
+
+    //build the tree if file doesn't exist
+    if(!fileExists)
+    {
+        switch(attributeType)
+        {
+            case INTEGER:
+                scanDataFile<int>(relationName);
+                break;
+
+            case DOUBLE:
+                scanDataFile<double>(relationName);
+                break;
+
+            case STRING:
+                scanDataFile<StringKey>(relationName);
+                break;
+        }
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::~BTreeIndex -- destructor
+// -----------------------------------------------------------------------------
+
+BTreeIndex::~BTreeIndex()
+{
+    //end any scan still in flight and write out the index
+    try
+    {
+        if(scanExecuting)
+        {
+            endScan();
+        }
+
+        bufMgr -> flushFile(file);
+    }
+
+    catch(const BadgerDbException &e)
+    {
+    }
+
+    delete file;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::Print Leaf Node
+// -----------------------------------------------------------------------------
+
+template <class T>
+void BTreeIndex::printLeafNode(LeafNode<T> *leaf, PageId leafNo)
+{
+    std::cout << "LeafNode pageNo:" << leafNo << "\n";
+    std::cout << "root sibling page: " << leaf -> rightSibPageNo << "\n";
+    std::cout << "number of keys: " << leaf -> numKeys << "\n";
+
+    for(int i = 0; i < leaf -> numKeys; i++)
+    {
+        std::cout << "index " << i << ": ";
+        std::cout << "Key: " << getLeafKey(leaf, i);
+        std::cout << " slotNumber: " << getLeafRid(leaf, i).slot_number;
+        std::cout << " PageNumber: " << getLeafRid(leaf, i).page_number;
+        std::cout << "\n";
+    }
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::Check if leaf Node is full
+// -----------------------------------------------------------------------------
+
+//a plain leaf is full when its arrays are; a posting leaf when there is no
+//room for a new key, or for the most a posting list can grow by when an
+//entry goes between two of its record ids
+template <class T>
+bool BTreeIndex::leafFull(LeafNode<T> *leaf, const T &key)
+{
+    if(leaf -> format == PLAIN_LEAF)
+    {
+        return leaf -> numKeys == LeafNode<T>::PLAINSIZE;
+    }
+
+    return leafBytes(leaf) + LeafNode<T>::GROUPSIZE + 2 * MAXRIDBYTES > LeafNode<T>::DATASIZE;
+}
+
+//a STRING leaf is full when key doesn't fit even after shortening the
+//prefix to what key shares with it
+bool BTreeIndex::leafFull(LeafNodeString *leaf, const StringKey &key)
+{
+    if(leaf -> numKeys == 0)
+    {
+        return false;
+    }
+
+    int prefixLength = 0;
+
+    while(prefixLength < leaf -> prefixLength && key.data[prefixLength] == leaf -> prefix[prefixLength])
+    {
+        prefixLength++;
+    }
+
+    //every suffix grows by the characters dropped from the prefix
+    int bytes = (leaf -> numKeys + 1) * STRINGENTRYSIZE
+              + (leaf -> suffixBytes - leaf -> numKeys)
+              + leaf -> numKeys * (leaf -> prefixLength - prefixLength)
+              + stringKeyLength(key) - prefixLength;
+
+    return bytes > LeafNodeString::DATASIZE;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex:: check if nonLeafNode is full
+// -----------------------------------------------------------------------------
+
+//same logic as leafNode
+template <class T>
+bool BTreeIndex::nonLeafFull(NonLeafNode<T> *nLeaf)
+{
+    return nLeaf -> numKeys == NonLeafNode<T>::SIZE;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex:: check if a node is underfull after a delete
+// -----------------------------------------------------------------------------
+//a leaf is underfull when less than half of its bytes are in use
+template <class T>
+bool BTreeIndex::leafUnderfull(LeafNode<T> *leaf)
+{
+    return leafBytes(leaf) < LeafNode<T>::DATASIZE / 2;
+}
+
+//a STRING leaf is underfull when less than half of its bytes are in use
+bool BTreeIndex::leafUnderfull(LeafNodeString *leaf)
+{
+    return leaf -> numKeys * (int)(sizeof(StringLeafSlot)) + leaf -> suffixBytes < LeafNodeString::DATASIZE / 2;
+}
+
+template <class T>
+bool BTreeIndex::nonLeafUnderfull(NonLeafNode<T> *nLeaf)
+{
+    return nLeaf -> numKeys < NonLeafNode<T>::SIZE / 2;
+}
+
+// -----------------------------------------------------------------------------
+// findInsertPlaceLeaf(key, leaf)
+// -----------------------------------------------------------------------------
+template <class T>
+int BTreeIndex::findInsertPlaceLeaf(const T &key, LeafNode<T> *leaf)
+{
+    //after any equal keys already in the leaf
+    return findLeafIndex(leaf, key, true);
+}
+
+template <class T>
+void BTreeIndex::printTree(NonLeafNode<T>* node)
+{
+    //this is a DFS version
+
+    //special case
+    if(node -> level == 2)
+    {
+        std::cout << "special case\n";
+
+        LeafNode<T> *realRootNode;
+        Page* realRoot;
+
+        PageId realRootNo = node -> pageNoArray[0];
+
+        bufMgr -> readPage(file, realRootNo, realRoot);
+
+        realRootNode = (LeafNode<T>*)(realRoot);
+
+        printLeafNode(realRootNode, realRootNo);
+
+        bufMgr -> unPinPage(file, realRootNo, false);
+        std::cout << "end of Special Case\n";
+    }
+
+    //every page id below is a leaf node
+    //base case
+    else if(node -> level == 1)
+    {
+        printNonLeafNode(node);
+    }
+
+    //recurse
+    else
+    {
+        printNonLeafNode(node);
+
+        //for each non leaf node underneath, retrieve it and print
+        for(int i = 0; i <= node -> numKeys; i++)
+        {
+            PageId getBelowNo = node -> pageNoArray[i];
+
+            Page* getPage;
+
+            bufMgr -> readPage(file, getBelowNo, getPage);
+
+            NonLeafNode<T> *gotNode = (NonLeafNode<T>*)(getPage);
+
+            printTree(gotNode);
+
+            bufMgr -> unPinPage(file, getBelowNo, false);
+        }
+    }
+}
+
+template <class T>
+void BTreeIndex::printNonLeafNode(NonLeafNode<T>* node)
+{
+    std::cout << "start of nonleaf Node\n";
+    std::cout << "keys: ";
+
+    for(int i = 0; i < node -> numKeys; i++)
+    {
+        std::cout << node -> keyArray[i] << " ";
+    }
+
+    std::cout << "\n";
+
+    if(node -> level == 1)
+    {
+        std::cout << "printing leaves\n";
+
+        for(int i = 0; i <= node -> numKeys; i++)
+        {
+            LeafNode<T> *leaf;
+            Page* leafPage;
+
+            PageId leafNo = node -> pageNoArray[i];
+
+            bufMgr -> readPage(file, leafNo, leafPage);
+
+            leaf = (LeafNode<T>*)(leafPage);
+
+            printLeafNode(leaf, leafNo);
+
+            bufMgr -> unPinPage(file, leafNo, false);
+        }
+    }
+
+    std::cout << "end of nonleaf Node\n";
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::insertLeaf
+// -----------------------------------------------------------------------------
+template <class T>
+void BTreeIndex::insertLeaf(const T &key, const RecordId rid, LeafNode<T> *leaf)
+{
+    insertLeafEntry(leaf, key, rid);
+}
+
+void BTreeIndex::insertLeaf(const StringKey &key, const RecordId rid, LeafNodeString *leaf)
+{
+    int index = findInsertPlaceLeaf(key, leaf);
+    int suffixLength = stringKeyLength(key) - leaf -> prefixLength;
+    int freeBytes = leaf -> suffixStart - leaf -> numKeys * (int)(sizeof(StringLeafSlot));
+
+    //key keeps the prefix and fits between the offset array and the suffixes
+    if(leaf -> numKeys > 0 && memcmp(key.data, leaf -> prefix, leaf -> prefixLength) == 0 && freeBytes >= STRINGENTRYSIZE + suffixLength)
+    {
+        StringLeafSlot *slots = getStringSlots(leaf);
+
+        std::copy_backward(slots + index, slots + leaf -> numKeys, slots + leaf -> numKeys + 1);
+
+        slots[index].pageNo = rid.page_number;
+        slots[index].slotNo = rid.slot_number;
+        appendStringSuffix(leaf, slots[index], key);
+
+        leaf -> numKeys += 1;
+        return;
+    }
+
+    //prefix shrinks or unused suffixes are in the way, rewrite the leaf
+    StringKey keys[LeafNodeString::SIZE + 1];
+    RecordId rids[LeafNodeString::SIZE + 1];
+
+    int length = decodeStringLeaf(leaf, keys, rids, index) + 1;
+
+    keys[index] = key;
+    rids[index] = rid;
+
+    formatStringLeaf(leaf, keys, rids, length);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::insertNonLeaf
+// -----------------------------------------------------------------------------
+template <class T>
+void BTreeIndex::insertNonLeaf(const T &key, const int slot, PageId newChild, NonLeafNode<T> *nLeaf)
+{
+    int index = slot;
+
+    //old child keeps its slot as the left half, so shift keys from index
+    //and children from index + 1
+    std::copy_backward(nLeaf -> keyArray + index, nLeaf -> keyArray + nLeaf -> numKeys, nLeaf -> keyArray + nLeaf -> numKeys + 1);
+    std::copy_backward(nLeaf -> pageNoArray + index + 1, nLeaf -> pageNoArray + nLeaf -> numKeys + 1, nLeaf -> pageNoArray + nLeaf -> numKeys + 2);
+
+    nLeaf -> keyArray[index] = key;
+    nLeaf -> pageNoArray[index + 1] = newChild;
+    nLeaf -> numKeys += 1;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::splitLeafArrays
+// -----------------------------------------------------------------------------
+template <class T>
+void BTreeIndex::splitLeafArrays(LeafNode<T> *leafNode, const T &key, const RecordId rid, PageId &sLeafNo, T &pushUp)
+{
+     //full leaf plus the new entry; leaves are compressed, so both halves
+     //are rewritten from the decoded entries
+     T copyKeyArray [LeafNode<T>::SIZE + 1];
+     RecordId copyRidArray [LeafNode<T>::SIZE + 1];
+
+     int index = findInsertPlaceLeaf(key, leafNode);
+     int length = readLeafEntries(leafNode, copyKeyArray, copyRidArray) + 1;
+
+     std::copy_backward(copyKeyArray + index, copyKeyArray + length - 1, copyKeyArray + length);
+     std::copy_backward(copyRidArray + index, copyRidArray + length - 1, copyRidArray + length);
+
+     copyKeyArray[index] = key;
+     copyRidArray[index] = rid;
+
+     //keys arriving in order only ever go to the rightmost leaf, so it keeps
+     //most of its entries instead of being left half full for good
+     int half = (index == length - 1 && leafNode -> rightSibPageNo == 0)
+         ? length - std::max(1, length / 10) : leafSplitPoint(leafNode, copyKeyArray, copyRidArray, length);
+
+     Page *sLeaf;
+
+     //left half stays in leafNode, only the right half needs a new page
+     bufMgr -> allocPage(file, sLeafNo, sLeaf);
+
+     LeafNode<T> *sLeafNode = (LeafNode<T>*)(sLeaf);
+
+     setLeafFormat(sLeafNode, getLeafFormat(leafNode));
+     writeLeafEntries(sLeafNode, copyKeyArray + half, copyRidArray + half, length - half);
+     sLeafNode -> rightSibPageNo = leafNode -> rightSibPageNo;
+
+     writeLeafEntries(leafNode, copyKeyArray, copyRidArray, half);
+     leafNode -> rightSibPageNo = sLeafNo;
+
+     bufMgr -> unPinPage(file, sLeafNo, true);
+
+     //shortest key between the halves goes up
+     pushUp = shortestSeparator(copyKeyArray[half - 1], copyKeyArray[half]);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::splitNonLeafArrays
+// -----------------------------------------------------------------------------
+template <class T>
+void BTreeIndex::splitNonLeafArrays(NonLeafNode<T> *node, const T &key, const int slot, PageId newChild, PageId &snLeafNo, T &pushUp)
+{
+     //full node plus the new key and child
+     T copyKeyArray [NonLeafNode<T>::SIZE + 1];
+     PageId copyPageNoArray [NonLeafNode<T>::SIZE + 2];
+
+     int index = slot;
+     int length = node -> numKeys + 1;
+
+     std::copy(node -> keyArray, node -> keyArray + index, copyKeyArray);
+     std::copy(node -> pageNoArray, node -> pageNoArray + index + 1, copyPageNoArray);
+
+     copyKeyArray[index] = key;
+     copyPageNoArray[index + 1] = newChild;
+
+     std::copy(node -> keyArray + index, node -> keyArray + node -> numKeys, copyKeyArray + index + 1);
+     std::copy(node -> pageNoArray + index + 1, node -> pageNoArray + node -> numKeys + 1, copyPageNoArray + index + 2);
+
+     //middle key goes up, keys left of it stay left
+     int half = length / 2;
+
+     Page *snLeaf;
+
+     //left half stays in node, only the right half needs a new page
+     bufMgr -> allocPage(file, snLeafNo, snLeaf);
+
+     NonLeafNode<T> *snLeafNode = (NonLeafNode<T>*)(snLeaf);
+
+     node -> numKeys = half;
+     std::copy(copyKeyArray, copyKeyArray + half, node -> keyArray);
+     std::copy(copyPageNoArray, copyPageNoArray + half + 1, node -> pageNoArray);
+
+     snLeafNode -> level = node -> level;
+     snLeafNode -> numKeys = length - half - 1;
+     std::copy(copyKeyArray + half + 1, copyKeyArray + length, snLeafNode -> keyArray);
+     std::copy(copyPageNoArray + half + 1, copyPageNoArray + length + 1, snLeafNode -> pageNoArray);
+
+     pushUp = copyKeyArray[half];
+
+     bufMgr -> unPinPage(file, snLeafNo, true);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::slit root
+// -----------------------------------------------------------------------------
+template <class T>
+void BTreeIndex::splitRoot(const int slot, PageId newChild, NonLeafNode<T> *root, const T &key)
+{
+     PageId snLeafNo;
+     T pushUp;
+
+     //old root keeps the left half
+     splitNonLeafArrays(root, key, slot, newChild, snLeafNo, pushUp);
+
+     PageId oldRootNo = rootPageNum;
+
+     bufMgr -> unPinPage(file, oldRootNo, true);
+
+     //new root above the two halves
+     Page *rootPage;
+     PageId rootId;
+     bufMgr -> allocPage(file, rootId, rootPage);
+
+     rootPageNum = rootId;
+
+     NonLeafNode<T> *rootNode = (NonLeafNode<T>*)(rootPage);
+
+     rootNode -> level = 0;
+     rootNode -> numKeys = 1;
+     rootNode -> keyArray[0] = pushUp;
+     rootNode -> pageNoArray[0] = oldRootNo;
+     rootNode -> pageNoArray[1] = snLeafNo;
+
+     bufMgr -> unPinPage(file, rootPageNum, true);
+
+     //record new root in meta page
+     Page *metPage;
+
+     bufMgr -> readPage(file, headerPageNum, metPage);
+
+     ((IndexMetaInfo*)(metPage)) -> rootPageNo = rootPageNum;
+
+     bufMgr -> unPinPage(file, headerPageNum, true);
+}
+
+template <class T>
+void BTreeIndex::splitNonLeafNode(const int slot, PageId newChild, PageId oldNode, NonLeafNode<T> *currNode, TreePath &path, const T &key)
+{
+     PageId snLeafNo;
+     T pushUp;
+
+     //old node keeps the left half
+     splitNonLeafArrays(currNode, key, slot, newChild, snLeafNo, pushUp);
+
+     bufMgr -> unPinPage(file, oldNode, true);
+
+     //get Prev Node, and the slot of the old node in it
+     int prevSlot;
+     PageId prevPageNo = path.pop(prevSlot);
+
+     Page *prevPage;
+     bufMgr -> readPage(file, prevPageNo, prevPage);
+
+     NonLeafNode<T> *prevNode = (NonLeafNode<T>*)(prevPage);
+
+     //see if we need to split the prevNode
+     if(nonLeafFull(prevNode))
+     {
+         if(prevPageNo == rootPageNum)
+         {
+             splitRoot(prevSlot, snLeafNo, prevNode, pushUp);
+         }
+
+         else
+         {
+             splitNonLeafNode(prevSlot, snLeafNo, prevPageNo, prevNode, path, pushUp);
+         }
+     }
+
+     else
+     {
+          insertNonLeaf(pushUp, prevSlot, snLeafNo, prevNode);
+
+          //clean up
+          bufMgr -> unPinPage(file, prevPageNo, true);
+      }
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::splitLeaf
+// -----------------------------------------------------------------------------
+template <class T>
+void BTreeIndex::splitLeaf(LeafNode<T> *leafNode, PageId oldLeaf, TreePath &path, const T &key, RecordId rid)
+{
+     PageId sLeafNo;
+     T pushUp;
+
+     //old leaf keeps the left half
+     splitLeafArrays(leafNode, key, rid, sLeafNo, pushUp);
+
+     bufMgr -> unPinPage(file, oldLeaf, true);
+
+     //see if nonleafnode is full
+     int prevSlot;
+     PageId prevNodeId = path.pop(prevSlot);
+
+     Page *prevPage;
+
+     bufMgr -> readPage(file, prevNodeId, prevPage);
+
+     NonLeafNode<T> *prevNode = (NonLeafNode<T>*)(prevPage);
+
+     if(nonLeafFull(prevNode))
+     {
+         if(prevNodeId == rootPageNum)
+         {
+             splitRoot(prevSlot, sLeafNo, prevNode, pushUp);
+         }
+
+         else
+         {
+             splitNonLeafNode(prevSlot, sLeafNo, prevNodeId, prevNode, path, pushUp);
+         }
+     }
+
+     else
+     {
+         insertNonLeaf(pushUp, prevSlot, sLeafNo, prevNode);
+
+         //unpin page
+         bufMgr -> unPinPage(file, prevNodeId, true);
+     }
+}
+
+template <class T>
+void BTreeIndex::findPath(TreePath &path, const T &key, bool leftmost)
+{
+    Page *currPage;
+    PageId nextPageNo;
+
+    nextPageNo = rootPageNum;
+    path.depth = 0;
+
+    bool reachedLeaf = false;
+
+    while(!reachedLeaf)
+    {
+        //get page
+        bufMgr -> readPage(file, nextPageNo, currPage);
+        PageId currPageNum = nextPageNo;
+
+        //getNonLeafNode
+        NonLeafNode<T> * actualNode = (NonLeafNode<T>*)(currPage);
+
+        //children are leaves
+        if(actualNode -> level == 1 || actualNode -> level == 2)
+        {
+            reachedLeaf = true;
+        }
+
+        //keys equal to a separator live right of it, but equal keys
+        //may also end the left child, so a scan starts left of them
+        int index = findKeyIndex(actualNode -> keyArray, actualNode -> numKeys, key, !leftmost);
+
+        //push curr node's page number and the child taken into stack
+        path.push(currPageNum, index);
+        nextPageNo = actualNode -> pageNoArray[index];
+
+        bufMgr -> unPinPage(file, currPageNum, false);
+    }
+
+    //leaf is reached
+    path.push(nextPageNo, -1);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::insertEntry
+// -----------------------------------------------------------------------------
+
+const void BTreeIndex::insertEntry(const void *key, const RecordId rid)
+{
+    switch(attributeType)
+    {
+        case INTEGER:
+            insertKey(keyAt<int>(key), rid);
+            break;
+
+        case DOUBLE:
+            insertKey(keyAt<double>(key), rid);
+            break;
+
+        case STRING:
+            insertKey(keyAt<StringKey>(key), rid);
+            break;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::insertKey
+// -----------------------------------------------------------------------------
+template <class T>
+void BTreeIndex::insertKey(const T &key, const RecordId rid)
+{
+    //keys inserted in order keep going to the same leaf
+    if(insertHintNo != 0 && insertAtHint(key, rid))
+    {
+        return;
+    }
+
+    Page *root;
+
+    //get root
+    bufMgr -> readPage(file, rootPageNum, root);
+
+    NonLeafNode<T> *rootNode = (NonLeafNode<T>*)(root);
+
+    //see if first case of root
+    if(rootNode -> level == 2)
+    {
+        LeafNode<T> *realRootNode;
+        Page* realRoot;
+
+        PageId realRootNo = rootNode -> pageNoArray[0];
+
+        bufMgr -> readPage(file, realRootNo, realRoot);
+
+        realRootNode = (LeafNode<T>*)(realRoot);
+
+        //tombstones make room before a split does
+        if(leafFull(realRootNode, key))
+        {
+            purgeTombstones(realRootNode);
+        }
+
+        if(leafFull(realRootNode, key))
+        {
+            PageId sLeafNo;
+            T pushUp;
+
+            //leaf keeps the left half and the level 2 root page becomes
+            //the level 1 root above both halves
+            splitLeafArrays(realRootNode, key, rid, sLeafNo, pushUp);
+
+            rootNode -> level = 1;
+            rootNode -> numKeys = 1;
+            rootNode -> keyArray[0] = pushUp;
+            rootNode -> pageNoArray[1] = sLeafNo;
+
+            bufMgr -> unPinPage(file, realRootNo, true);
+            bufMgr -> unPinPage(file, rootPageNum, true);
+        }
+
+        else
+        {
+            insertLeaf(key, rid, realRootNode);
+            insertHintNo = realRootNo;
+
+            //clean up
+            bufMgr -> unPinPage(file, realRootNo, true);
+            bufMgr -> unPinPage(file, rootPageNum, false);
+        }
+    }
+
+    else
+    {
+        bufMgr -> unPinPage(file, rootPageNum, false);
+
+        TreePath path;
+
+        //get path from root to leaf
+        findPath(path, key);
+
+        //get leaf
+        int leafSlot;
+        PageId leafNo = path.pop(leafSlot);
+
+        Page *leaf;
+        bufMgr -> readPage(file, leafNo, leaf);
+
+        LeafNode<T> *leafNode = (LeafNode<T>*)(leaf);
+
+        if(leafFull(leafNode, key))
+        {
+            purgeTombstones(leafNode);
+        }
+
+        if(leafFull(leafNode, key))
+        {
+            splitLeaf(leafNode, leafNo, path, key, rid);
+        }
+
+        else
+        {
+            insertLeaf(key, rid, leafNode);
+            insertHintNo = leafNo;
+
+            //clean up
+            bufMgr -> unPinPage(file, leafNo, true);
+        }
+    }
+
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::insertAtHint
+// -----------------------------------------------------------------------------
+template <class T>
+bool BTreeIndex::insertAtHint(const T &key, const RecordId rid)
+{
+    Page *leaf;
+
+    bufMgr -> readPage(file, insertHintNo, leaf);
+
+    LeafNode<T> *leafNode = (LeafNode<T>*)(leaf);
+    int numKeys = leafNode -> numKeys;
+
+    //the separator left of a leaf is at most its first key and the one
+    //right of it is past its last key, so a descent would end here too
+    bool inRange = numKeys > 0 && !(key < getLeafKey(leafNode, 0))
+        && (leafNode -> rightSibPageNo == 0 || !(getLeafKey(leafNode, numKeys - 1) < key));
+
+    if(!inRange || leafFull(leafNode, key))
+    {
+        bufMgr -> unPinPage(file, insertHintNo, false);
+        return false;
+    }
+
+    insertLeaf(key, rid, leafNode);
+
+    bufMgr -> unPinPage(file, insertHintNo, true);
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::deleteEntry
+// -----------------------------------------------------------------------------
+
+const void BTreeIndex::deleteEntry(const void *key, const RecordId rid)
+{
+    switch(attributeType)
+    {
+        case INTEGER:
+            deleteKey(keyAt<int>(key), rid);
+            break;
+
+        case DOUBLE:
+            deleteKey(keyAt<double>(key), rid);
+            break;
+
+        case STRING:
+            deleteKey(keyAt<StringKey>(key), rid);
+            break;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::deleteKey
+// -----------------------------------------------------------------------------
+template <class T>
+void BTreeIndex::deleteKey(const T &key, const RecordId rid)
+{
+    bool underfull = false;
+
+    if(!deleteFromNonLeaf(rootPageNum, key, rid, underfull))
+    {
+        throw NoSuchKeyFoundException();
+    }
+
+    collapseRoot<T>();
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::collapseRoot
+// -----------------------------------------------------------------------------
+template <class T>
+void BTreeIndex::collapseRoot()
+{
+    Page *root;
+
+    bufMgr -> readPage(file, rootPageNum, root);
+
+    NonLeafNode<T> *rootNode = (NonLeafNode<T>*)(root);
+
+    //root still has at least two children
+    if(rootNode -> numKeys > 0 || rootNode -> level == 2)
+    {
+        bufMgr -> unPinPage(file, rootPageNum, false);
+        return;
+    }
+
+    //a single leaf left hangs off the root like in the initial tree
+    if(rootNode -> level == 1)
+    {
+        rootNode -> level = 2;
+
+        bufMgr -> unPinPage(file, rootPageNum, true);
+        return;
+    }
+
+    //single non leaf child becomes the root
+    PageId oldRootNo = rootPageNum;
+
+    rootPageNum = rootNode -> pageNoArray[0];
+
+    bufMgr -> unPinPage(file, oldRootNo, false);
+    bufMgr -> disposePage(file, oldRootNo);
+
+    //record new root in meta page
+    Page *metPage;
+
+    bufMgr -> readPage(file, headerPageNum, metPage);
+
+    ((IndexMetaInfo*)(metPage)) -> rootPageNo = rootPageNum;
+
+    bufMgr -> unPinPage(file, headerPageNum, true);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::deleteFromLeaf
+// -----------------------------------------------------------------------------
+template <class T>
+bool BTreeIndex::deleteFromLeaf(PageId leafNo, const T &key, const RecordId rid, bool &underfull)
+{
+    Page *leaf;
+
+    bufMgr -> readPage(file, leafNo, leaf);
+
+    LeafNode<T> *leafNode = (LeafNode<T>*)(leaf);
+
+    int i = findLeafEntry(leafNode, key, rid);
+
+    if(i == -1)
+    {
+        bufMgr -> unPinPage(file, leafNo, false);
+        return false;
+    }
+
+    //a tombstone leaves the tree as it is
+    if(deleteMode == LAZY_DELETE)
+    {
+        markLeafTombstone(leafNode, i);
+    }
+
+    else
+    {
+        removeLeafEntry(leafNode, i);
+
+        underfull = leafUnderfull(leafNode);
+    }
+
+    bufMgr -> unPinPage(file, leafNo, true);
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::deleteFromNonLeaf
+// -----------------------------------------------------------------------------
+template <class T>
+bool BTreeIndex::deleteFromNonLeaf(PageId nodeNo, const T &key, const RecordId rid, bool &underfull)
+{
+    Page *page;
+
+    bufMgr -> readPage(file, nodeNo, page);
+
+    NonLeafNode<T> *node = (NonLeafNode<T>*)(page);
+
+    bool leafChildren = node -> level == 1 || node -> level == 2;
+
+    //equal keys may be spread over every child from the first separator
+    //not less than key up to the first one greater than it
+    int first = findKeyIndex(node -> keyArray, node -> numKeys, key, false);
+    int last = findKeyIndex(node -> keyArray, node -> numKeys, key, true);
+
+    for(int i = first; i <= last; i++)
+    {
+        bool childUnderfull = false;
+        bool found;
+
+        if(leafChildren)
+        {
+            found = deleteFromLeaf(node -> pageNoArray[i], key, rid, childUnderfull);
+        }
+
+        else
+        {
+            found = deleteFromNonLeaf(node -> pageNoArray[i], key, rid, childUnderfull);
+        }
+
+        if(!found)
+        {
+            continue;
+        }
+
+        //the single leaf under the initial root has no siblings
+        if(childUnderfull && node -> numKeys > 0)
+        {
+            if(leafChildren)
+            {
+                rebalanceLeaves(node, i);
+            }
+
+            else
+            {
+                rebalanceNonLeaves(node, i);
+            }
+        }
+
+        underfull = nonLeafUnderfull(node);
+
+        bufMgr -> unPinPage(file, nodeNo, childUnderfull);
+        return true;
+    }
+
+    bufMgr -> unPinPage(file, nodeNo, false);
+    return false;
+}
+
+//removes the separator at index and the child right of it
+template <class T>
+static void removeNonLeafEntry(NonLeafNode<T> *node, const int index)
+{
+    std::copy(node -> keyArray + index + 1, node -> keyArray + node -> numKeys, node -> keyArray + index);
+    std::copy(node -> pageNoArray + index + 2, node -> pageNoArray + node -> numKeys + 1, node -> pageNoArray + index + 1);
+
+    node -> numKeys -= 1;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::rebalanceLeaves
+// -----------------------------------------------------------------------------
+template <class T>
+void BTreeIndex::rebalanceLeaves(NonLeafNode<T> *parent, const int index)
+{
+    //pair the child with its right sibling, the last child with its left one
+    int left = index < parent -> numKeys ? index : index - 1;
+
+    PageId leftNo = parent -> pageNoArray[left];
+    PageId rightNo = parent -> pageNoArray[left + 1];
+
+    Page *leftPage;
+    Page *rightPage;
+
+    bufMgr -> readPage(file, leftNo, leftPage);
+    bufMgr -> readPage(file, rightNo, rightPage);
+
+    LeafNode<T> *leftLeaf = (LeafNode<T>*)(leftPage);
+    LeafNode<T> *rightLeaf = (LeafNode<T>*)(rightPage);
+
+    //entries of both leaves, in order
+    T keys [2 * LeafNode<T>::SIZE];
+    RecordId rids [2 * LeafNode<T>::SIZE];
+
+    int length = readLeafEntries(leftLeaf, keys, rids);
+    length += readLeafEntries(rightLeaf, keys + length, rids + length);
+
+    if(leafEntriesFit(leftLeaf, keys, rids, length))
+    {
+        //merge the right leaf into the left one and unlink it
+        writeLeafEntries(leftLeaf, keys, rids, length);
+        leftLeaf -> rightSibPageNo = rightLeaf -> rightSibPageNo;
+
+        removeNonLeafEntry(parent, left);
+
+        bufMgr -> unPinPage(file, leftNo, true);
+        bufMgr -> unPinPage(file, rightNo, false);
+
+        bufMgr -> disposePage(file, rightNo);
+
+        //the page may come back as a non leaf node
+        if(insertHintNo == rightNo)
+        {
+            insertHintNo = 0;
+        }
+    }
+
+    else
+    {
+        //borrow: even the entries out over both leaves
+        int half = leafSplitPoint(leftLeaf, keys, rids, length);
+
+        writeLeafEntries(leftLeaf, keys, rids, half);
+        writeLeafEntries(rightLeaf, keys + half, rids + half, length - half);
+
+        parent -> keyArray[left] = shortestSeparator(keys[half - 1], keys[half]);
+
+        bufMgr -> unPinPage(file, leftNo, true);
+        bufMgr -> unPinPage(file, rightNo, true);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::rebalanceNonLeaves
+// -----------------------------------------------------------------------------
+template <class T>
+void BTreeIndex::rebalanceNonLeaves(NonLeafNode<T> *parent, const int index)
+{
+    int left = index < parent -> numKeys ? index : index - 1;
+
+    PageId leftNo = parent -> pageNoArray[left];
+    PageId rightNo = parent -> pageNoArray[left + 1];
+
+    Page *leftPage;
+    Page *rightPage;
+
+    bufMgr -> readPage(file, leftNo, leftPage);
+    bufMgr -> readPage(file, rightNo, rightPage);
+
+    NonLeafNode<T> *leftNode = (NonLeafNode<T>*)(leftPage);
+    NonLeafNode<T> *rightNode = (NonLeafNode<T>*)(rightPage);
+
+    //keys of both nodes with the separator between them, and their children
+    T keys [2 * NonLeafNode<T>::SIZE + 1];
+    PageId pageNos [2 * NonLeafNode<T>::SIZE + 2];
+
+    std::copy(leftNode -> keyArray, leftNode -> keyArray + leftNode -> numKeys, keys);
+    keys[leftNode -> numKeys] = parent -> keyArray[left];
+    std::copy(rightNode -> keyArray, rightNode -> keyArray + rightNode -> numKeys, keys + leftNode -> numKeys + 1);
+
+    std::copy(leftNode -> pageNoArray, leftNode -> pageNoArray + leftNode -> numKeys + 1, pageNos);
+    std::copy(rightNode -> pageNoArray, rightNode -> pageNoArray + rightNode -> numKeys + 1, pageNos + leftNode -> numKeys + 1);
+
+    int length = leftNode -> numKeys + 1 + rightNode -> numKeys;
+
+    if(length <= NonLeafNode<T>::SIZE)
+    {
+        //merge the right node into the left one
+        leftNode -> numKeys = length;
+        std::copy(keys, keys + length, leftNode -> keyArray);
+        std::copy(pageNos, pageNos + length + 1, leftNode -> pageNoArray);
+
+        removeNonLeafEntry(parent, left);
+
+        bufMgr -> unPinPage(file, leftNo, true);
+        bufMgr -> unPinPage(file, rightNo, false);
+
+        bufMgr -> disposePage(file, rightNo);
+    }
+
+    else
+    {
+        //borrow: middle key goes up, keys left of it stay left
+        int half = length / 2;
+
+        leftNode -> numKeys = half;
+        std::copy(keys, keys + half, leftNode -> keyArray);
+        std::copy(pageNos, pageNos + half + 1, leftNode -> pageNoArray);
+
+        parent -> keyArray[left] = keys[half];
+
+        rightNode -> numKeys = length - half - 1;
+        std::copy(keys + half + 1, keys + length, rightNode -> keyArray);
+        std::copy(pageNos + half + 1, pageNos + length + 1, rightNode -> pageNoArray);
+
+        bufMgr -> unPinPage(file, leftNo, true);
+        bufMgr -> unPinPage(file, rightNo, true);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::setDeleteMode
+// -----------------------------------------------------------------------------
+
+const void BTreeIndex::setDeleteMode(const DeleteMode mode)
+{
+    deleteMode = mode;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::compact
+// -----------------------------------------------------------------------------
+
+const void BTreeIndex::compact()
+{
+    switch(attributeType)
+    {
+        case INTEGER:
+            compactTree<int>();
+            break;
+
+        case DOUBLE:
+            compactTree<double>();
+            break;
+
+        case STRING:
+            compactTree<StringKey>();
+            break;
+    }
+}
+
+template <class T>
+void BTreeIndex::compactTree()
+{
+    compactNode<T>(rootPageNum);
+
+    //merges may leave a chain of single children on top
+    PageId oldRootNo;
+
+    do
+    {
+        oldRootNo = rootPageNum;
+        collapseRoot<T>();
+    }
+    while(rootPageNum != oldRootNo);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::compactNode
+// -----------------------------------------------------------------------------
+template <class T>
+bool BTreeIndex::compactNode(PageId nodeNo)
+{
+    Page *page;
+
+    bufMgr -> readPage(file, nodeNo, page);
+
+    NonLeafNode<T> *node = (NonLeafNode<T>*)(page);
+
+    bool dirty;
+
+    if(node -> level == 1 || node -> level == 2)
+    {
+        dirty = compactLeaves(node);
+    }
+
+    else
+    {
+        dirty = false;
+
+        //right to left, so a merge with the right neighbour only pulls in
+        //a subtree that is already compacted
+        for(int i = node -> numKeys; i >= 0; i--)
+        {
+            if(compactNode<T>(node -> pageNoArray[i]) && node -> numKeys > 0)
+            {
+                rebalanceNonLeaves(node, i);
+                dirty = true;
+            }
+        }
+    }
+
+    bool underfull = nonLeafUnderfull(node);
+
+    bufMgr -> unPinPage(file, nodeNo, dirty);
+
+    return underfull;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::compactLeaves
+// -----------------------------------------------------------------------------
+template <class T>
+bool BTreeIndex::compactLeaves(NonLeafNode<T> *node)
+{
+    bool merged = false;
+
+    //current leaf stays pinned while it takes in the neighbours right of it
+    int curr = 0;
+    PageId currNo = node -> pageNoArray[0];
+    Page *currPage;
 
-    Page *root;
- 
-    //get root
-    bufMgr -> readPage(file, rootPageNum, root);   
+    bufMgr -> readPage(file, currNo, currPage);
 
-    NonLeafNodeInt *rootNode = (NonLeafNodeInt*)(root);
+    LeafNode<T> *currLeaf = (LeafNode<T>*)(currPage);
+    bool currDirty = purgeTombstones(currLeaf);
 
-    //see if first case of root
-    if(rootNode -> level == 2)
+    //entries of the current leaf and the next one, in order
+    T keys [2 * LeafNode<T>::SIZE];
+    RecordId rids [2 * LeafNode<T>::SIZE];
+
+    while(curr < node -> numKeys)
     {
-        LeafNodeInt *realRootNode;
-        Page* realRoot;
+        PageId nextNo = node -> pageNoArray[curr + 1];
+        Page *nextPage;
 
-        PageId realRootNo = rootNode -> pageNoArray[0];
+        bufMgr -> readPage(file, nextNo, nextPage);
 
-        bufMgr -> readPage(file, realRootNo, realRoot);
+        LeafNode<T> *nextLeaf = (LeafNode<T>*)(nextPage);
+        bool nextDirty = purgeTombstones(nextLeaf);
 
-        realRootNode = (LeafNodeInt*)(realRoot);
+        int length = 0;
+        bool merge = false;
 
-        if(leafFull(realRootNode))
+        if(leafUnderfull(currLeaf) || leafUnderfull(nextLeaf))
         {
-            LeafNodeInt tempLeaf = *realRootNode;
+            length = readLeafEntries(currLeaf, keys, rids);
+            length += readLeafEntries(nextLeaf, keys + length, rids + length);
 
-            bufMgr -> unPinPage(file, realRootNo, false);
-            bufMgr -> unPinPage(file, rootPageNum, false);
+            merge = leafEntriesFit(currLeaf, keys, rids, length);
+        }
 
-            bufMgr -> flushFile(file);
+        if(merge)
+        {
+            //merge the next leaf into the current one and unlink it
+            writeLeafEntries(currLeaf, keys, rids, length);
+            currLeaf -> rightSibPageNo = nextLeaf -> rightSibPageNo;
+            currDirty = true;
 
-            //try to delete page
-            try
-            {
-                file -> deletePage(realRootNo);
-            }
+            removeNonLeafEntry(node, curr);
+            merged = true;
 
-            catch(InvalidPageException e)
-            {
-            }
+            bufMgr -> unPinPage(file, nextNo, false);
+            bufMgr -> disposePage(file, nextNo);
 
-            try
+            if(insertHintNo == nextNo)
             {
-                file -> deletePage(rootPageNum);
+                insertHintNo = 0;
             }
+        }
 
-            catch(InvalidPageException e)
-            {
-            }
+        else
+        {
+            //current leaf is done, the next one takes its place
+            bufMgr -> unPinPage(file, currNo, currDirty);
 
-            Page *newRoot;
-            PageId newRootNo;
+            curr++;
+            currNo = nextNo;
+            currLeaf = nextLeaf;
+            currDirty = nextDirty;
+        }
+    }
 
-            //create new root
-            bufMgr -> allocPage(file, newRootNo, newRoot);
+    bufMgr -> unPinPage(file, currNo, currDirty);
 
-            rootPageNum = newRootNo;
+    return merged;
+}
 
-            //create leaves before setting new non-leaf node
-            int copyKeyArray [INTARRAYLEAFSIZE + 1];
-            RecordId copyRidArray [INTARRAYLEAFSIZE + 1];
+// -----------------------------------------------------------------------------
+// BTreeIndex::findScanStart
+// -----------------------------------------------------------------------------
+template <class T>
+int BTreeIndex::findScanStart(LeafNode<T> *leafNode)
+{
+    T lowVal;
+    T highVal;
 
-            int index = findInsertPlaceSplit(tempLeaf.keyArray, intKey, true);
+    getScanRange(lowVal, highVal);
 
-            for(int i = 0; i < index; i++)
-            {
-                copyKeyArray[i] = tempLeaf.keyArray[i];
-                copyRidArray[i] = tempLeaf.ridArray[i];
-            }
+    //first key past the low bound
+    int index = findLeafIndex(leafNode, lowVal, lowOp == GT);
 
-            copyKeyArray[index] = *intKey;
-            copyRidArray[index] = rid;
+    if(index < leafNode -> numKeys)
+    {
+        seekLeafCursor(leafNode, index, scanCursor);
+    }
 
-            for(int i = index; i < INTARRAYLEAFSIZE; i++)
-            {
-                copyKeyArray[i+1] = tempLeaf.keyArray[i];
-                copyRidArray[i+1] = tempLeaf.ridArray[i];
-            }
+    return index;
+}
 
-            //split in half
-            int half = (INTARRAYLEAFSIZE + 1) / 2;
-            int firstKeys[INTARRAYLEAFSIZE];
-            int secondKeys[INTARRAYLEAFSIZE];
-            RecordId firstRid[INTARRAYLEAFSIZE];
-            RecordId secondRid[INTARRAYLEAFSIZE];
+//scanCursor is on entry indexStart of leafNode, if there is one
+template <class T>
+void BTreeIndex::updateScanVars(Page *currPage, PageId currPageNo, LeafNode<T> *leafNode, int indexStart)
+{
+    T lowVal;
+    T highVal;
 
-            //split arrays in two
-            for(int i = 0; i < INTARRAYLEAFSIZE; i++)
-            {
-                secondKeys[i] = -1;
-                secondRid[i] = {0,0};
+    getScanRange(lowVal, highVal);
 
-                if(i >= half)
-                {
-                    firstKeys[i] = -1;
-                    firstRid[i] = {0,0};
-                }
+    while(true)
+    {
+        for(; indexStart < leafNode -> numKeys; indexStart++)
+        {
+            //keys are sorted, so the scan is over at the first key past the high bound
+            const T &key = getCursorKey(leafNode, indexStart, scanCursor);
+            bool uBound = (highOp == LT) ? (key < highVal) : !(highVal < key);
 
-                else
-                {
-                    firstKeys[i] = copyKeyArray[i];
-                    firstRid[i] = copyRidArray[i];
-                }
+            if(!uBound)
+            {
+                //not found
+                bufMgr -> unPinPage(file, currPageNo, false);
+
+                nextEntry = -1;
+                currentPageNum = 0;
+                return;
             }
 
-            for(int i = half; i < (INTARRAYLEAFSIZE + 1); i++)
+            //tombstones are skipped on the leaf already pinned
+            if(!isTombstone(scanCursor.rid))
             {
-                secondKeys[i - half] = copyKeyArray[i];
-                secondRid[i - half] = copyRidArray[i]; 
+                currentPageNum = currPageNo;
+                currentPageData = currPage;
+                nextEntry = indexStart;
+                return;
             }
-        
-            Page *fLeaf;
-            PageId fLeafNo;
-            Page *sLeaf;
-            PageId sLeafNo;
 
-            //create new leaves
-            bufMgr -> allocPage(file, fLeafNo, fLeaf);
-            bufMgr -> allocPage(file, sLeafNo, sLeaf);
+            nextLeafCursor(leafNode, indexStart, scanCursor);
+        }
 
-            LeafNodeInt *fLeafNode = (LeafNodeInt*)(fLeaf);
-            LeafNodeInt *sLeafNode = (LeafNodeInt*)(sLeaf);
+        //scanned past the end of this leaf, move on to the next one
+        PageId nextLeaf = leafNode -> rightSibPageNo;
 
-            fLeafNode -> rightSibPageNo = sLeafNo;
-            std::copy(std::begin(firstKeys), std::end(firstKeys), fLeafNode -> keyArray);
-            std::copy(std::begin(firstRid), std::end(firstRid), fLeafNode -> ridArray);
+        //unpin page
+        bufMgr -> unPinPage(file, currPageNo, false);
 
-            sLeafNode -> rightSibPageNo = 0;
-            std::copy(std::begin(secondKeys), std::end(secondKeys), sLeafNode -> keyArray);
-            std::copy(std::begin(secondRid), std::end(secondRid), sLeafNode -> ridArray);
+        //no more leaves
+        if(nextLeaf == 0)
+        {
+            nextEntry = -1;
+            currentPageNum = 0;
+            return;
+        }
 
-            //convert back into pages
-            Page* convert = (Page*)(fLeafNode);
-            fLeaf[0] = convert[0];
-            
-            convert = (Page*)(sLeafNode);
-            sLeaf[0] = convert[0];
+        bufMgr -> readPage(file, nextLeaf, currPage);
 
-            //create new root
-            NonLeafNodeInt *newRootNode = (NonLeafNodeInt*)(newRoot);
-            for(int i = 0; i < INTARRAYNONLEAFSIZE; i++)
-            {
-                newRootNode -> keyArray[i] = -1;
-                newRootNode -> pageNoArray[i] = 0;
-            }
- 
-            newRootNode -> pageNoArray[INTARRAYNONLEAFSIZE] = 0;
+        currPageNo = nextLeaf;
+        leafNode = (LeafNode<T>*)(currPage);
+        indexStart = findScanStart(leafNode);
+    }
+}
 
-            newRootNode -> keyArray[0] = copyKeyArray[half];
-            
-            newRootNode -> pageNoArray[0] = fLeafNo;
-            newRootNode -> pageNoArray[1] = sLeafNo;
+// -----------------------------------------------------------------------------
+// BTreeIndex::scan range
+// -----------------------------------------------------------------------------
+void BTreeIndex::setScanRange(const int &lowVal, const int &highVal)
+{
+    lowValInt = lowVal;
+    highValInt = highVal;
+}
 
-            newRootNode -> level = 1;
+void BTreeIndex::setScanRange(const double &lowVal, const double &highVal)
+{
+    lowValDouble = lowVal;
+    highValDouble = highVal;
+}
 
-            //after creation, recast
-            convert = (Page*)(newRootNode);
+void BTreeIndex::setScanRange(const StringKey &lowVal, const StringKey &highVal)
+{
+    //keep all STRINGSIZE characters, padding included
+    lowValString.assign(lowVal.data, STRINGSIZE);
+    highValString.assign(highVal.data, STRINGSIZE);
+}
 
-            newRoot[0] = convert[0];
+void BTreeIndex::getScanRange(int &lowVal, int &highVal) const
+{
+    lowVal = lowValInt;
+    highVal = highValInt;
+}
 
-            //unpin all new pages
-            bufMgr -> unPinPage(file, newRootNo, true);
-            bufMgr -> unPinPage(file, fLeafNo, true);
-            bufMgr -> unPinPage(file, sLeafNo, true);
+void BTreeIndex::getScanRange(double &lowVal, double &highVal) const
+{
+    lowVal = lowValDouble;
+    highVal = highValDouble;
+}
 
-            Page *metPage;
+void BTreeIndex::getScanRange(StringKey &lowVal, StringKey &highVal) const
+{
+    memcpy(lowVal.data, lowValString.data(), STRINGSIZE);
+    memcpy(highVal.data, highValString.data(), STRINGSIZE);
+}
 
-            bufMgr -> readPage(file, 1, metPage);
+// -----------------------------------------------------------------------------
+// BTreeIndex::lookup
+// -----------------------------------------------------------------------------
 
-            IndexMetaInfo *metaPage = (IndexMetaInfo*)metPage;
+const void BTreeIndex::lookup(const void *key, std::vector<RecordId> &outRids)
+{
+    switch(attributeType)
+    {
+        case INTEGER:
+            lookupKey(keyAt<int>(key), &outRids);
+            break;
 
-            metaPage -> rootPageNo = newRootNo;
+        case DOUBLE:
+            lookupKey(keyAt<double>(key), &outRids);
+            break;
 
-            //set back
-            convert = (Page*)(metaPage);
+        case STRING:
+            lookupKey(keyAt<StringKey>(key), &outRids);
+            break;
+    }
+}
 
-            metPage[0] = convert[0];
+// -----------------------------------------------------------------------------
+// BTreeIndex::exists
+// -----------------------------------------------------------------------------
 
-            bufMgr -> unPinPage(file, 1, true);
+const bool BTreeIndex::exists(const void *key)
+{
+    switch(attributeType)
+    {
+        case INTEGER:
+            return lookupKey(keyAt<int>(key), NULL);
 
-            //try flush then dispose
-            bufMgr -> flushFile(file);
+        case DOUBLE:
+            return lookupKey(keyAt<double>(key), NULL);
 
-        }
+        case STRING:
+            return lookupKey(keyAt<StringKey>(key), NULL);
+    }
 
-        else
-        {
-            insertLeaf(intKey, rid, realRootNode);
+    return false;
+}
 
-            //update page
-            Page* convert = (Page*)(realRootNode);
-            
-            realRoot[0] = convert[0];
+// -----------------------------------------------------------------------------
+// BTreeIndex::lookupBatch
+// -----------------------------------------------------------------------------
 
-            //clean up
-            bufMgr -> unPinPage(file, realRootNo, true);
+const void BTreeIndex::lookupBatch(const void* const* keys, const int numKeys, std::vector< std::vector<RecordId> > &outRids)
+{
+    switch(attributeType)
+    {
+        case INTEGER:
+            lookupBatchKeys<int>(keys, numKeys, outRids);
+            break;
 
-            //std::cout << "here\n";
+        case DOUBLE:
+            lookupBatchKeys<double>(keys, numKeys, outRids);
+            break;
 
-            bufMgr -> unPinPage(file, rootPageNum, false);
-        }
+        case STRING:
+            lookupBatchKeys<StringKey>(keys, numKeys, outRids);
+            break;
     }
+}
 
-    else
-    {
-        std::list <PageId> path;
+// -----------------------------------------------------------------------------
+// BTreeIndex::lookupKey
+// -----------------------------------------------------------------------------
+template <class T>
+bool BTreeIndex::lookupKey(const T &key, std::vector<RecordId> *outRids)
+{
+    TreePath path;
 
-        //get path from root to leaf
-        findPath(path, intKey);
+    //duplicates of key may end the leaf left of a separator equal to it
+    findPath(path, key, true);
 
-        //std::cout << "The contents of fifth are: ";
-        //for (std::list<PageId>::iterator it = path.begin(); it != path.end(); it++)
-          //  std::cout << *it << ' ';
+    PageId leafNo = path.top();
+    Page *leaf;
 
-        //std::cout << '\n';
+    bufMgr -> readPage(file, leafNo, leaf);
 
-        //get leaf
-        PageId leafNo = path.front();
-        path.pop_front();
+    bool found = findLeafKey(key, leafNo, leaf, outRids);
 
-        Page *leaf;
-        bufMgr -> readPage(file, leafNo, leaf);
+    bufMgr -> unPinPage(file, leafNo, false);
 
-        LeafNodeInt *leafNode = (LeafNodeInt*)(leaf);
+    return found;
+}
 
-         //std::cout << "The contents of path are: ";
-           // for (std::list<PageId>::iterator it = path.begin(); it != path.end(); it++)
-             //   std::cout << *it << ' ';
+// -----------------------------------------------------------------------------
+// BTreeIndex::findLeafKey
+// -----------------------------------------------------------------------------
+template <class T>
+bool BTreeIndex::findLeafKey(const T &key, PageId &leafNo, Page *&leaf, std::vector<RecordId> *outRids)
+{
+    LeafNode<T> *leafNode = (LeafNode<T>*)(leaf);
+    LeafCursor cursor;
+    bool found = false;
+    int index = findLeafIndex(leafNode, key, false);
 
-            //std::cout << '\n';
+    if(index < leafNode -> numKeys)
+    {
+        seekLeafCursor(leafNode, index, cursor);
+    }
 
-        if(leafFull(leafNode))
+    while(true)
+    {
+        for(; index < leafNode -> numKeys; index++)
         {
-            std::cout << "need to split leaf\n";
-            splitLeaf(leafNode, leafNo, path, intKey, rid);
+            //entries from index on are not less than key
+            if(key < getCursorKey(leafNode, index, cursor))
+            {
+                return found;
+            }
+
+            if(!isTombstone(cursor.rid))
+            {
+                found = true;
+
+                if(outRids == NULL)
+                {
+                    return true;
+                }
+
+                outRids -> push_back(cursor.rid);
+            }
+
+            nextLeafCursor(leafNode, index, cursor);
         }
 
-        else
-        {
-            insertLeaf(intKey, rid, leafNode);
+        //key may go on in the next leaf
+        PageId nextLeaf = leafNode -> rightSibPageNo;
 
-            //update page
-            Page* convert = (Page*)(leafNode);
+        if(nextLeaf == 0)
+        {
+            return found;
+        }
 
-            leaf[0] = convert[0];
+        bufMgr -> unPinPage(file, leafNo, false);
+        bufMgr -> readPage(file, nextLeaf, leaf);
 
-            //clean up
-            bufMgr -> unPinPage(file, leafNo, true);
+        leafNo = nextLeaf;
+        leafNode = (LeafNode<T>*)(leaf);
+        index = 0;
 
-            bufMgr -> unPinPage(file, rootPageNum, false);
+        if(leafNode -> numKeys > 0)
+        {
+            seekLeafCursor(leafNode, index, cursor);
         }
     }
-    
 }
 
-void BTreeIndex::updateScanVars(Page *currPage, PageId currPageNo, LeafNodeInt *leafNode, int indexStart)
+// -----------------------------------------------------------------------------
+// BTreeIndex::lookupBatchKeys
+// -----------------------------------------------------------------------------
+
+//orders probe indexes by their key
+template <class T>
+struct ProbeLess
 {
-    int index = -1;
- 
-    //scan leaf
-    for(int i = indexStart; i < INTARRAYLEAFSIZE; i++)
-    {
-        bool uBound = false;
-        bool lBound = false;
+    const std::vector<T> &keys;
 
-        if(leafNode -> keyArray[i] == -1)
-        {
-            break;
-        }
+    ProbeLess(const std::vector<T> &keysIn) : keys(keysIn) {}
 
-        if(highOp == LT)
-        {
-            uBound = (leafNode -> keyArray[i] < highValInt);
-        }
+    bool operator()(const int a, const int b) const
+    {
+        return keys[a] < keys[b];
+    }
+};
 
-        else if(highOp == LTE)
-        {
-            uBound = (leafNode -> keyArray[i] <= highValInt);
-        }
+template <class T>
+void BTreeIndex::lookupBatchKeys(const void* const* keys, const int numKeys, std::vector< std::vector<RecordId> > &outRids)
+{
+    std::vector<T> probeKeys;
+    std::vector<int> order;
 
-        if(lowOp == GT)
-        {
-            lBound = (leafNode -> keyArray[i] > lowValInt);
-        }
+    outRids.assign(numKeys, std::vector<RecordId>());
 
-        else if(lowOp == GTE)
-        {
-            lBound = (leafNode -> keyArray[i] >= lowValInt);
-        }
-        
-        if(lBound && uBound)
-        {
-            index = i;
-            break;
-        }
+    for(int i = 0; i < numKeys; i++)
+    {
+        probeKeys.push_back(keyAt<T>(keys[i]));
+        order.push_back(i);
     }
 
-    if(index == -1)
+    if(numKeys == 0)
     {
-        //finished scanning leaf
+        return;
+    }
 
-        //in next leaf maybe
-        PageId nextLeaf = leafNode -> rightSibPageNo;
-        
-        //unpin page
-        bufMgr -> unPinPage(file, currPageNo, false);
-        bufMgr -> flushFile(file);
+    //in key order, probes going to the same node are next to each other
+    std::sort(order.begin(), order.end(), ProbeLess<T>(probeKeys));
 
-        Page* leafPage;
+    std::vector<T> sorted;
 
+    for(int i = 0; i < numKeys; i++)
+    {
+        sorted.push_back(probeKeys[order[i]]);
+    }
 
-        bufMgr -> readPage(file, nextLeaf, leafPage);
+    PageId leafNo = 0;
+    Page *leaf = NULL;
 
-        LeafNodeInt *nextLeafNode = (LeafNodeInt*)(leafPage);
+    lookupBatchNode(rootPageNum, &sorted[0], &order[0], numKeys, outRids, leafNo, leaf);
 
-        bool uBound = false;
-        bool lBound = false;
+    if(leafNo != 0)
+    {
+        bufMgr -> unPinPage(file, leafNo, false);
+    }
+}
 
-        if(highOp == LT)
-        {
-            uBound = nextLeafNode -> keyArray[0] < highValInt;
-        }
+// -----------------------------------------------------------------------------
+// BTreeIndex::lookupBatchNode
+// -----------------------------------------------------------------------------
+template <class T>
+void BTreeIndex::lookupBatchNode(PageId nodeNo, const T *keys, const int *order, const int count, std::vector< std::vector<RecordId> > &outRids, PageId &leafNo, Page *&leaf)
+{
+    Page *page;
 
-        else if(highOp == LTE)
-        {
-            uBound = nextLeafNode -> keyArray[0] <= highValInt;
-        }
+    bufMgr -> readPage(file, nodeNo, page);
 
-        if(lowOp == GT)
-        {
-            lBound = nextLeafNode -> keyArray[0] > lowValInt;
-        }
+    NonLeafNode<T> *node = (NonLeafNode<T>*)(page);
+    bool leafChildren = node -> level == 1 || node -> level == 2;
+    int i = 0;
+
+    while(i < count)
+    {
+        int index = findKeyIndex(node -> keyArray, node -> numKeys, keys[i], false);
+        int end = i + 1;
 
-        else if(lowOp == GTE)
+        //every probe up to the separator goes to the same child
+        while(end < count && (index == node -> numKeys || !(node -> keyArray[index] < keys[end])))
         {
-            lBound = nextLeafNode -> keyArray[0] >= lowValInt;
+            end++;
         }
-        
-        if(lBound && uBound)
+
+        PageId child = node -> pageNoArray[index];
+
+        if(!leafChildren)
         {
-            //index found
-            currentPageNum = nextLeaf;
-            currentPageData = leafPage;
-            nextEntry = 0;
+            lookupBatchNode(child, keys + i, order + i, end - i, outRids, leafNo, leaf);
         }
 
         else
         {
-            //not found
-            bufMgr -> unPinPage(file, nextLeaf, false);
-            bufMgr -> flushFile(file);
-            
-            nextEntry = -1;
-            currentPageNum = 0;
+            for(int j = i; j < end; j++)
+            {
+                //a repeated probe gets the same answer
+                if(j > 0 && !(keys[j - 1] < keys[j]))
+                {
+                    outRids[order[j]] = outRids[order[j - 1]];
+                    continue;
+                }
+
+                //the leaf of the last probe stays pinned, since the next
+                //one is often on it too
+                if(leafNo != child)
+                {
+                    if(leafNo != 0)
+                    {
+                        bufMgr -> unPinPage(file, leafNo, false);
+                    }
+
+                    leafNo = child;
+                    bufMgr -> readPage(file, leafNo, leaf);
+                }
+
+                findLeafKey(keys[j], leafNo, leaf, &outRids[order[j]]);
+            }
         }
-    }
 
-    else
-    {
-        currentPageNum = currPageNo;
-        currentPageData = currPage;
-        nextEntry = index;
+        i = end;
     }
 
+    bufMgr -> unPinPage(file, nodeNo, false);
 }
 
 // -----------------------------------------------------------------------------
@@ -1758,94 +3721,142 @@ const void BTreeIndex::startScan(const void* lowValParm,
         throw BadOpcodesException();
     }
 
-    //too late for this BS
-    //just gonna assume it's integer
-    int * lowVal = (int*)(lowValParm);
-    int * highVal = (int*)(highValParm);
+    switch(attributeType)
+    {
+        case INTEGER:
+            startScanKey(keyAt<int>(lowValParm), lowOpParm, keyAt<int>(highValParm), highOpParm);
+            break;
+
+        case DOUBLE:
+            startScanKey(keyAt<double>(lowValParm), lowOpParm, keyAt<double>(highValParm), highOpParm);
+            break;
+
+        case STRING:
+            startScanKey(keyAt<StringKey>(lowValParm), lowOpParm, keyAt<StringKey>(highValParm), highOpParm);
+            break;
+    }
+}
 
-    if(*highVal < *lowVal)
+// -----------------------------------------------------------------------------
+// BTreeIndex::startScanKey
+// -----------------------------------------------------------------------------
+template <class T>
+void BTreeIndex::startScanKey(const T &lowVal, const Operator lowOpParm, const T &highVal, const Operator highOpParm)
+{
+    if(highVal < lowVal)
     {
         throw BadScanrangeException();
     }
 
-    lowValInt = *lowVal;
-    highValInt = *highVal;
+    //only one scan at a time
+    if(scanExecuting)
+    {
+        endScan();
+    }
+
+    setScanRange(lowVal, highVal);
     lowOp = lowOpParm;
     highOp = highOpParm;
 
     scanExecuting = true;
-    
+
     //get pageid
-    std::list <PageId> path;
+    TreePath path;
 
-    //get path from root to leaf
-    findPath(path, lowVal);
+    //get path from root to the leftmost leaf that may hold lowVal
+    findPath(path, lowVal, true);
 
-    PageId leafNo = path.front();
+    PageId leafNo = path.top();
     Page* leaf;
 
     bufMgr -> readPage(file, leafNo, leaf);
-    
-    LeafNodeInt *leafNode = (LeafNodeInt*)(leaf);
 
-    updateScanVars(leaf, leafNo, leafNode, 0);
+    LeafNode<T> *leafNode = (LeafNode<T>*)(leaf);
+
+    updateScanVars(leaf, leafNo, leafNode, findScanStart(leafNode));
 }
 
 // -----------------------------------------------------------------------------
 // BTreeIndex::scanNext
 // -----------------------------------------------------------------------------
 
-const void BTreeIndex::scanNext(RecordId& outRid) 
+const void BTreeIndex::scanNext(RecordId& outRid)
 {
+    if(!scanExecuting)
+    {
+        throw ScanNotInitializedException();
+    }
+
     if(nextEntry == -1)
     {
-        std::cout << "threw\n";
         throw IndexScanCompletedException();
     }
 
-    LeafNodeInt *leafNode = (LeafNodeInt*)(currentPageData);
-     
-    outRid = leafNode -> ridArray[nextEntry];
-    
-    updateScanVars(currentPageData, currentPageNum, leafNode, nextEntry + 1);
+    switch(attributeType)
+    {
+        case INTEGER:
+            scanNextKey<int>(outRid);
+            break;
+
+        case DOUBLE:
+            scanNextKey<double>(outRid);
+            break;
+
+        case STRING:
+            scanNextKey<StringKey>(outRid);
+            break;
+    }
+}
+
+template <class T>
+void BTreeIndex::scanNextKey(RecordId& outRid)
+{
+    LeafNode<T> *leafNode = (LeafNode<T>*)(currentPageData);
+
+    outRid = scanCursor.rid;
+
+    //the rest of a key's record ids stream without checking the bounds
+    //again; a lazily deleted one goes through updateScanVars to be skipped
+    bool sameKey = nextLeafCursor(leafNode, nextEntry, scanCursor);
+
+    nextEntry++;
+
+    if(!sameKey || isTombstone(scanCursor.rid))
+    {
+        updateScanVars(currentPageData, currentPageNum, leafNode, nextEntry);
+    }
 }
 
 // -----------------------------------------------------------------------------
 // BTreeIndex::endScan
 // -----------------------------------------------------------------------------
 //
-const void BTreeIndex::endScan() 
+const void BTreeIndex::endScan()
 {
     if(!scanExecuting)
     {
         throw ScanNotInitializedException();
     }
 
-    else
+    scanExecuting = false;
+
+    //scan still holds the leaf it is positioned on
+    if(currentPageNum != 0)
     {
-        try
-        {
-            scanExecuting = false;
-            bufMgr -> flushFile(file);
-        }
+        bufMgr -> unPinPage(file, currentPageNum, false);
+    }
 
-        catch(PagePinnedException e)
-        {
-            std::cout << "trying to prematurely end scan\n";
-            std::cout << "trying to unpin current page\n";
-            try
-            {
-                bufMgr -> unPinPage(file, currentPageNum, false);
-                bufMgr -> flushFile(file);
-            }
+    nextEntry = -1;
+    currentPageNum = 0;
+}
 
-            catch(PagePinnedException e)
-            {
-                bufMgr -> printSelf();
-                std::cout << "WTH is pinned?";
-            }
-        }
-    }
+// -----------------------------------------------------------------------------
+// BTreeIndex::checkpoint
+// -----------------------------------------------------------------------------
+
+const void BTreeIndex::checkpoint()
+{
+    bufMgr -> flushFile(file);
 }
 
 }
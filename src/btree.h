@@ -16,7 +16,8 @@
 #include "page.h"
 #include "file.h"
 #include "buffer.h"
-#include <list>
+#include "key_search.h"
+#include <vector>
 
 namespace badgerdb
 {
@@ -42,21 +43,99 @@ enum Operator
 	GT		/* Greater Than */
 };
 
+/**
+ * @brief How BTreeIndex::deleteEntry() removes entries. Set with BTreeIndex::setDeleteMode().
+ */
+enum DeleteMode
+{
+	EAGER_DELETE,	/* Remove the entry and rebalance underfull nodes right away */
+	LAZY_DELETE		/* Only mark the entry as a tombstone; BTreeIndex::compact() cleans up later */
+};
+
+/**
+ * @brief How INTEGER and DOUBLE leaves store their entries. Chosen when the index is created; STRING leaves
+ * are always prefix compressed.
+ */
+enum LeafFormat
+{
+	PLAIN_LEAF,		/* A key and a record id per entry */
+	POSTING_LEAF	/* Each distinct key once, with its record ids delta encoded; for keys repeated on many records */
+};
+
+
+/**
+ * @brief Number of characters of a STRING attribute that make up its key.
+ */
+const int STRINGSIZE = 10;
+
+/**
+ * @brief Key of a STRING index: the first STRINGSIZE characters of the attribute, zero padded.
+ * Compared byte by byte like strncmp, so keys can be stored and compared without a terminator.
+*/
+struct StringKey{
+  /**
+   * Characters of the key.
+   */
+	char data[ STRINGSIZE ];
+
+	StringKey() {}
+
+	explicit StringKey( const char *s )
+	{
+		size_t length = strnlen( s, STRINGSIZE );
+		memcpy( data, s, length );
+		memset( data + length, 0, STRINGSIZE - length );
+	}
+
+	bool operator<( const StringKey &rhs ) const
+	{
+		return memcmp( data, rhs.data, STRINGSIZE ) < 0;
+	}
+
+	bool operator==( const StringKey &rhs ) const
+	{
+		return memcmp( data, rhs.data, STRINGSIZE ) == 0;
+	}
+
+	bool operator!=( const StringKey &rhs ) const
+	{
+		return !( *this == rhs );
+	}
+};
 
 /**
- * @brief Number of key slots in B+Tree leaf for INTEGER key.
+ * @brief Prints the characters of a STRING key up to its terminator.
  */
-//                                                  sibling ptr             key               rid
-const  int INTARRAYLEAFSIZE = ( Page::SIZE - sizeof( PageId ) ) / ( sizeof( int ) + sizeof( RecordId ) );
-//const int INTARRAYLEAFSIZE = 3;
+inline std::ostream& operator<<( std::ostream &out, const StringKey &key )
+{
+	return out.write( key.data, strnlen( key.data, STRINGSIZE ) );
+}
+
+/**
+ * @brief Number of key slots in B+Tree non-leaf nodes for key type T, computed from Page::SIZE.
+ */
+template <class T>
+struct KeyArraySize{
+	//                                               level     key count      extra pageNo                  key       pageNo
+	static const int nonLeaf = ( Page::SIZE - sizeof( int ) - sizeof( int ) - sizeof( PageId ) ) / ( sizeof( T ) + sizeof( PageId ) );
+};
 
 /**
  * @brief Number of key slots in B+Tree non-leaf for INTEGER key.
  */
-//                                                     level     extra pageNo                  key       pageNo
-const  int INTARRAYNONLEAFSIZE = ( Page::SIZE - sizeof( int ) - sizeof( PageId ) ) / ( sizeof( int ) + sizeof( PageId ) );
+const  int INTARRAYNONLEAFSIZE = KeyArraySize<int>::nonLeaf;
 //const int INTARRAYNONLEAFSIZE = 3;
 
+/**
+ * @brief Number of key slots in B+Tree non-leaf for DOUBLE key.
+ */
+const  int DOUBLEARRAYNONLEAFSIZE = KeyArraySize<double>::nonLeaf;
+
+/**
+ * @brief Number of key slots in B+Tree non-leaf for STRING key.
+ */
+const  int STRINGARRAYNONLEAFSIZE = KeyArraySize<StringKey>::nonLeaf;
+
 /**
  * @brief Structure to store a key-rid pair. It is used to pass the pair to functions that 
  * add to or make changes to the leaf node pages of the tree. Is templated for the key member.
@@ -73,6 +152,17 @@ public:
 	}
 };
 
+/**
+ * @brief Default fraction of the slots in each leaf/non-leaf node that the bulk loader fills.
+ * Leaving some slack keeps the first inserts after a build from splitting every leaf.
+ */
+const double BULKLOAD_FILLFACTOR = 0.9;
+
+/**
+ * @brief Default number of key-rid pairs the bulk loader sorts in memory before spilling a sorted run to disk.
+ */
+const int BULKLOAD_RUNSIZE = 1 << 20;
+
 /**
  * @brief Structure to store a key page pair which is used to pass the key and page to functions that make 
  * any modifications to the non leaf pages of the tree.
@@ -92,17 +182,57 @@ public:
 /**
  * @brief Overloaded operator to compare the key values of two rid-key pairs
  * and if they are the same compares to see if the first pair has
- * a smaller rid.pageNo value.
+ * a smaller rid, by page number and then slot number.
 */
 template <class T>
 bool operator<( const RIDKeyPair<T>& r1, const RIDKeyPair<T>& r2 )
 {
 	if( r1.key != r2.key )
 		return r1.key < r2.key;
-	else
+	else if( r1.rid.page_number != r2.rid.page_number )
 		return r1.rid.page_number < r2.rid.page_number;
+	else
+		return r1.rid.slot_number < r2.rid.slot_number;
 }
 
+/**
+ * @brief Structure of a page in a sorted run spilled to disk by the bulk loader when the
+ * key-rid pairs of the base relation do not fit in one run.
+*/
+template <class T>
+struct SortRunPage{
+  /**
+   * Number of key-rid pairs that fit in one page.
+   */
+	//                                      count
+	static const int SIZE = ( Page::SIZE - sizeof( int ) ) / sizeof( RIDKeyPair<T> );
+
+  /**
+   * Number of pairs stored in this page.
+   */
+	int numPairs;
+
+  /**
+   * Stores key-rid pairs, sorted by key.
+   */
+	RIDKeyPair<T> pairArray[ SIZE ];
+};
+
+/**
+ * @brief Sorted run of key-rid pairs spilled to disk by the bulk loader.
+*/
+struct SortRun{
+  /**
+   * Name of the file holding the run.
+   */
+	std::string fileName;
+
+  /**
+   * Number of pairs in the run.
+   */
+	int numPairs;
+};
+
 /**
  * @brief The meta page, which holds metadata for Index file, is always first page of the btree index file and is cast
  * to the following structure to store or retrieve information from it.
@@ -139,50 +269,328 @@ These structures basically are the format in which the information is stored in
 node they are. The level memeber of each non leaf structure seen below is set to 1 if the nodes 
 at this level are just above the leaf nodes - but it is set to 2 if the node is the root and it hasn't been split yet. 
 Otherwise set to 0.
+Only the first numKeys keys of a node are in use; a non-leaf node with numKeys keys has numKeys + 1 children.
 */
 
 /**
- * @brief Structure for all non-leaf nodes when the key is of INTEGER type.
+ * @brief Structure for all non-leaf nodes, for keys of type T (int, double or StringKey).
 */
-struct NonLeafNodeInt{
+template <class T>
+struct NonLeafNode{
+  /**
+   * Number of key slots.
+   */
+	static const int SIZE = KeyArraySize<T>::nonLeaf;
+
   /**
    * Level of the node in the tree.
    */
 	int level;
 
+  /**
+   * Number of keys in use.
+   */
+	int numKeys;
+
   /**
    * Stores keys.
    */
-	int keyArray[ INTARRAYNONLEAFSIZE ];
+	T keyArray[ SIZE ];
 
   /**
    * Stores page numbers of child pages which themselves are other non-leaf/leaf nodes in the tree.
    */
-	PageId pageNoArray[ INTARRAYNONLEAFSIZE + 1 ];
+	PageId pageNoArray[ SIZE + 1 ];
 };
 
 
 /**
- * @brief Structure for all leaf nodes when the key is of INTEGER type.
+ * @brief Entry of the group array of an INTEGER or DOUBLE leaf. The entries of a leaf that share a key
+ * form a group, which stores the key once and the record ids of its entries as a posting list. A key with
+ * more entries than a list holds gets several groups in a row, so the keys of a leaf can repeat.
 */
-struct LeafNodeInt{
+struct PostingGroup{
   /**
-   * Stores keys.
+   * Index, among the entries of the leaf, of the first entry of the group.
+   */
+	std::uint16_t first;
+
+  /**
+   * Offset of the posting list in data. It runs up to the offset of the next group's list, or DATASIZE.
+   */
+	std::uint16_t offset;
+};
+
+/**
+ * @brief Structure for all leaf nodes, for keys of type T (int or double; STRING leaves are specialized below).
+ * A PLAIN_LEAF fills data with an array of PLAINSIZE keys followed by an array of as many record ids.
+ * A POSTING_LEAF stores each distinct key once per posting list: data starts with the keys, sorted, followed
+ * by the group array ( PostingGroup, one per list ) and free space. The posting lists are packed at the back
+ * of data in key order, each record id encoded as its difference from the one before it, so a key repeated on
+ * many records costs a couple of bytes per record instead of a key and a RecordId.
+*/
+template <class T>
+struct LeafNode{
+  /**
+   * Number of bytes shared by the keys, the group array and the posting lists.
+   */
+	//                                        key count      sibling ptr      format, numGroups, listStart
+	static const int DATASIZE = Page::SIZE - sizeof( int ) - sizeof( PageId ) - 3 * sizeof( int );
+
+  /**
+   * Number of entries a PLAIN_LEAF holds.
+   */
+	static const int PLAINSIZE = DATASIZE / ( sizeof( T ) + sizeof( RecordId ) );
+
+  /**
+   * Bytes each distinct key takes besides its posting list.
+   */
+	static const int GROUPSIZE = sizeof( T ) + sizeof( PostingGroup );
+
+  /**
+   * Most entries a leaf of either format can hold, reached when a POSTING_LEAF's share a key; an encoded
+   * record id takes at least two bytes.
    */
-	int keyArray[ INTARRAYLEAFSIZE ];
+	static const int SIZE = DATASIZE / 2;
 
   /**
-   * Stores RecordIds.
+   * Most distinct keys a POSTING_LEAF can hold.
    */
-	RecordId ridArray[ INTARRAYLEAFSIZE ];
+	static const int MAXKEYS = DATASIZE / ( GROUPSIZE + 2 );
+
+  /**
+   * Number of entries in use, counting each record id of a posting list.
+   */
+	int numKeys;
 
   /**
    * Page number of the leaf on the right side.
 	 * This linking of leaves allows to easily move from one leaf to the next leaf during index scan.
    */
 	PageId rightSibPageNo;
+
+  /**
+   * LeafFormat of the leaf; every leaf of an index has the same.
+   */
+	int format;
+
+  /**
+   * Number of distinct keys of a POSTING_LEAF.
+   */
+	int numGroups;
+
+  /**
+   * Start of the posting lists, which fill data[ listStart, DATASIZE ).
+   */
+	int listStart;
+
+  /**
+   * Keys and group array followed by free space and the posting lists.
+   */
+	char data[ DATASIZE ];
+};
+
+/**
+ * @brief Entry of the offset array of a STRING leaf: record id of the entry and offset, inside the
+ * leaf's data, of its suffix. A suffix is stored as a length byte followed by the characters of the key
+ * past the leaf's prefix.
+*/
+struct StringLeafSlot{
+  /**
+   * Page number of the record.
+   */
+	PageId pageNo;
+
+  /**
+   * Slot number of the record.
+   */
+	SlotId slotNo;
+
+  /**
+   * Offset of the suffix in data.
+   */
+	std::uint16_t suffixOffset;
+};
+
+/**
+ * @brief Structure for leaf nodes when the key is of STRING type. Keys are prefix compressed: the prefix
+ * shared by all keys of the leaf is stored once and each entry keeps only the rest of its key.
+ * The offset array grows from the front of data in key order and the suffixes are packed from the back,
+ * so the number of entries a leaf holds depends on how long its keys are past the prefix.
+*/
+template <>
+struct LeafNode<StringKey>{
+  /**
+   * Number of bytes shared by the offset array and the suffixes.
+   */
+	//                                        key count      sibling ptr     prefixLength, suffixStart, suffixBytes        prefix
+	static const int DATASIZE = Page::SIZE - sizeof( int ) - sizeof( PageId ) - 3 * sizeof( std::uint16_t ) - STRINGSIZE;
+
+  /**
+   * Most entries a leaf can hold, reached when every key equals the prefix.
+   */
+	static const int SIZE = DATASIZE / ( sizeof( StringLeafSlot ) + 1 );
+
+  /**
+   * Number of keys in use.
+   */
+	int numKeys;
+
+  /**
+   * Page number of the leaf on the right side.
+   */
+	PageId rightSibPageNo;
+
+  /**
+   * Number of characters in prefix.
+   */
+	std::uint16_t prefixLength;
+
+  /**
+   * Start of the suffixes; data[ suffixStart, DATASIZE ) may also hold suffixes no longer in use.
+   */
+	std::uint16_t suffixStart;
+
+  /**
+   * Bytes of the suffixes in use, length bytes included.
+   */
+	std::uint16_t suffixBytes;
+
+  /**
+   * Characters every key of the leaf starts with.
+   */
+	char prefix[ STRINGSIZE ];
+
+  /**
+   * Offset array ( StringLeafSlot, sorted by key ) followed by free space and the suffixes.
+   */
+	char data[ DATASIZE ];
 };
 
+/**
+ * @brief Most key slots in B+Tree leaf for STRING key. How many are usable depends on the prefix the keys share.
+ */
+const  int STRINGARRAYLEAFSIZE = LeafNode<StringKey>::SIZE;
+
+/**
+ * @brief Most entries in B+Tree leaf for INTEGER key, reached when they share a key.
+ */
+const  int INTARRAYLEAFSIZE = LeafNode<int>::SIZE;
+
+/**
+ * @brief Most entries in B+Tree leaf for DOUBLE key, reached when they share a key.
+ */
+const  int DOUBLEARRAYLEAFSIZE = LeafNode<double>::SIZE;
+
+/**
+ * @brief Position of a scan inside the posting list of a leaf, so the record ids of a key are decoded one
+ * after another rather than looked up by entry index. Only rid is used on other leaves.
+*/
+struct LeafCursor{
+  /**
+   * Posting list the scan is in.
+   */
+	int group;
+
+  /**
+   * Index of the first entry past the posting list.
+   */
+	int groupEnd;
+
+  /**
+   * Offset in the leaf's data of the next encoded record id.
+   */
+	int offset;
+
+  /**
+   * Record id of the entry the scan is on.
+   */
+	RecordId rid;
+};
+
+/**
+ * @brief Pages on the way from the root down to a leaf, along with the slot of pageNoArray taken at each
+ * non leaf node, so a split can update its parent without searching it again. Kept on the stack: page
+ * numbers are 32 bits and every non leaf node has at least two children, so no tree is deeper than MAXDEPTH.
+*/
+struct TreePath{
+	static const int MAXDEPTH = 32;
+
+  /**
+   * Page numbers from the root down; the deepest page is pageNo[ depth - 1 ].
+   */
+	PageId pageNo[ MAXDEPTH ];
+
+  /**
+   * Index of the child taken at each page; -1 for a leaf.
+   */
+	int slot[ MAXDEPTH ];
+
+  /**
+   * Number of pages on the path.
+   */
+	int depth;
+
+	TreePath() : depth(0) {}
+
+  /**
+   * Adds a page below the deepest one.
+   */
+	void push(const PageId pageNum, const int childSlot)
+	{
+		pageNo[depth] = pageNum;
+		slot[depth] = childSlot;
+		depth++;
+	}
+
+  /**
+   * Removes the deepest page and returns its page number.
+   * @param childSlot	Set to the slot taken at that page
+   */
+	PageId pop(int &childSlot)
+	{
+		depth--;
+		childSlot = slot[depth];
+		return pageNo[depth];
+	}
+
+  /**
+   * Page number of the deepest page.
+   */
+	PageId top() const
+	{
+		return pageNo[depth - 1];
+	}
+};
+
+/**
+ * @brief Node structures when the key is of INTEGER type.
+*/
+typedef NonLeafNode<int> NonLeafNodeInt;
+typedef LeafNode<int> LeafNodeInt;
+
+/**
+ * @brief Node structures when the key is of DOUBLE type.
+*/
+typedef NonLeafNode<double> NonLeafNodeDouble;
+typedef LeafNode<double> LeafNodeDouble;
+
+/**
+ * @brief Node structures when the key is of STRING type.
+*/
+typedef NonLeafNode<StringKey> NonLeafNodeString;
+typedef LeafNode<StringKey> LeafNodeString;
+
+static_assert(sizeof(NonLeafNodeInt) <= Page::SIZE, "Non-leaf node must fit in a page.");
+static_assert(sizeof(LeafNodeInt) == Page::SIZE, "Leaf node must fill a page.");
+static_assert(sizeof(NonLeafNodeDouble) <= Page::SIZE, "Non-leaf node must fit in a page.");
+static_assert(sizeof(LeafNodeDouble) == Page::SIZE, "Leaf node must fill a page.");
+static_assert(sizeof(NonLeafNodeString) <= Page::SIZE, "Non-leaf node must fit in a page.");
+static_assert(sizeof(LeafNodeString) == Page::SIZE, "Leaf node must fill a page.");
+static_assert(sizeof(SortRunPage<int>) <= Page::SIZE, "Sort run page must fit in a page.");
+static_assert(sizeof(SortRunPage<double>) <= Page::SIZE, "Sort run page must fit in a page.");
+static_assert(sizeof(SortRunPage<StringKey>) <= Page::SIZE, "Sort run page must fit in a page.");
+
 
 /**
  * @brief BTreeIndex class. It implements a B+ Tree index on a single attribute of a
@@ -245,6 +653,11 @@ class BTreeIndex {
    */
 	int			nextEntry;
 
+  /**
+   * Position of the scan in the posting list of the entry at nextEntry.
+   */
+	LeafCursor	scanCursor;
+
   /**
    * Page number of current page being scanned.
    */
@@ -295,6 +708,36 @@ class BTreeIndex {
    */
 	Operator	highOp;
 
+  /**
+   * Fraction of node slots filled when the index is bulk loaded.
+   */
+	double		fillFactor;
+
+  /**
+   * Number of key-rid pairs the bulk loader sorts in memory before spilling a run.
+   */
+	int		runSize;
+
+  /**
+   * Format of the INTEGER or DOUBLE leaves the index creates.
+   */
+	LeafFormat	leafFormat;
+
+  /**
+   * Frames of the ring the bulk loader scans the relation through, or 0 to read it through the whole pool.
+   */
+	std::uint32_t	ringSize;
+
+  /**
+   * How deleteEntry removes entries.
+   */
+	DeleteMode	deleteMode;
+
+  /**
+   * Leaf the last insert went to, tried before descending from the root; 0 if none.
+   */
+	PageId	insertHintNo;
+
   /**
       * Set the index file of the btree
       * if the file exists, open it and return true
@@ -311,44 +754,98 @@ class BTreeIndex {
       * @param bufMgrIn                                            Buffer Manager Instance
       * @param outIndexName        Return the name of index file.  
       * @param fileExists - whether or not the file exists
-      * @return the meta page of the index file
+      * @return the root page number recorded in the meta page; a new meta page is written in place in its frame
   */	
   
-      IndexMetaInfo *getMetaPage(BufMgr *bufMgrIn, bool fileExists, const std::string & relationName,  const int attrByteOffset,
+      PageId getMetaPage(BufMgr *bufMgrIn, bool fileExists, const std::string & relationName,  const int attrByteOffset,
                 const Datatype attrType);
   /**
-      * Scan each record in the data file
-      * insert into B+ Tree
-      * and place into bufMgr
+      * Scan each record in the data file, collect its (key, rid) pair
+      * and bulk load the B+ Tree bottom-up from the sorted pairs.
+      * Pairs are sorted in memory, or in runs merged from disk when there
+      * are more than runSize of them.
       * @param relationName - the relation's name
       *
   */
+      template <class T>
       void scanDataFile(const std::string & relationName);
 
+  /**
+      * Sorts the pairs collected so far and writes them out as one sorted run
+      * @param pairs - pairs to spill; emptied on return
+      * @param runs - runs written so far; new run is appended
+  */
+      template <class T>
+      void spillRun(std::vector< RIDKeyPair<T> > &pairs, std::vector<SortRun> &runs);
+
+  /**
+      * Merges the sorted runs and packs the merged pairs into leaves
+      * @param runs - runs to merge; the run files are removed afterwards
+      * @param numPairs - total number of pairs over all runs
+      * @param level - receives a (separator, pageNo) entry for every leaf packed
+  */
+      template <class T>
+      void mergeRuns(const std::vector<SortRun> &runs, const int numPairs, std::vector< PageKeyPair<T> > &level);
+
+  /**
+      * Packs a sorted slice of pairs into a new leaf and links it to the previous leaf
+      * @param pairs - sorted pairs to place in the leaf
+      * @param count - number of pairs
+      * @param prevLeafNo - leaf packed before this one (0 if none); set to the new leaf
+      * @param level - receives the (separator, pageNo) entry of the new leaf
+  */
+      template <class T>
+      void packLeaf(const RIDKeyPair<T> *pairs, const int count, PageId &prevLeafNo, std::vector< PageKeyPair<T> > &level);
+
+  /**
+      * Builds the non-leaf levels on top of the packed leaves until a single root
+      * remains, then records the root in the meta page
+      * @param level - (separator, pageNo) entries of the leaves, left to right
+  */
+      template <class T>
+      void packNonLeafLevels(std::vector< PageKeyPair<T> > &level);
+
   /**
     *Creates initial root of the tree
   */  
+      template <class T>
       void createInitRoot();
 
   /**
     * Creates initial leaf node
     * @param leafNo - page number of leaf node 
   */
+      template <class T>
       void createInitLeaf(PageId &leafNo);
 
   /**
     * Prints out the leaf node
     * @param leaf - leaf node to print out
   */
-      void printLeafNode(LeafNodeInt *leaf, PageId leafNo);
+      template <class T>
+      void printLeafNode(LeafNode<T> *leaf, PageId leafNo);
+
+  /**
+    * Number of the sorted pairs at the front of pairs the bulk loader packs into the next leaf
+    * @param pairs - sorted pairs not packed yet
+    * @param available - number of pairs at pairs
+    * @param remaining - number of pairs not packed yet, available ones included
+    * @return number of pairs for the next leaf
+  */
+      template <class T>
+      int leafFillCount(const RIDKeyPair<T> *pairs, const int available, const int remaining);
+      int leafFillCount(const RIDKeyPair<StringKey> *pairs, const int available, const int remaining);
 
   /**
     * returns true if the leaf is full
     * false otherwise
     * @param leaf - the leaf node we're testing fullness for
-    * @return true if full; false otherwise
+    * @param key - key that we want to insert
+    * @return true if key doesn't fit; false otherwise
   */
-      bool leafFull(LeafNodeInt *leaf);
+      template <class T>
+      bool leafFull(LeafNode<T> *leaf, const T &key);
+      bool leafFull(LeafNodeString *leaf, const StringKey &key);
 
   /**
     * returns true if nonleafnode is full
@@ -356,7 +853,25 @@ class BTreeIndex {
     * @param nLeaf - non leaf node we're testing fullness for
     * @return true if full; false otherwise
   */
-      bool nonLeafFull(NonLeafNodeInt *nLeaf);
+      template <class T>
+      bool nonLeafFull(NonLeafNode<T> *nLeaf);
+
+  /**
+    * returns true if the leaf is less than half full after a delete
+    * @param leaf - the leaf node we're testing
+    * @return true if the leaf should borrow from or merge with a sibling
+  */
+      template <class T>
+      bool leafUnderfull(LeafNode<T> *leaf);
+      bool leafUnderfull(LeafNodeString *leaf);
+
+  /**
+    * returns true if the non leaf node is less than half full after a delete
+    * @param nLeaf - non leaf node we're testing
+    * @return true if the node should borrow from or merge with a sibling
+  */
+      template <class T>
+      bool nonLeafUnderfull(NonLeafNode<T> *nLeaf);
 
   /**
     * returns the index of where to insert key into leaf
@@ -364,7 +879,8 @@ class BTreeIndex {
     * @param key - key that we are inserting
     * @return index to insert
   */
-     int findInsertPlaceLeaf(int *key, LeafNodeInt *leaf);
+     template <class T>
+     int findInsertPlaceLeaf(const T &key, LeafNode<T> *leaf);
       
   /**
     * Inserts key into leaf
@@ -372,57 +888,248 @@ class BTreeIndex {
     * @param rid - record id that we are inserting
     * @param leaf - leaf node we are inserting key and rid into
   */
-     void insertLeaf(int *key, const RecordId rid, LeafNodeInt *leaf);
+     template <class T>
+     void insertLeaf(const T &key, const RecordId rid, LeafNode<T> *leaf);
+     void insertLeaf(const StringKey &key, const RecordId rid, LeafNodeString *leaf);
 
   /**
-    * returns the index of where to insert key into leaf
-    * @param leaf - the leaf node we're inserting key into
+    * Inserts key into leaf
     * @param key - key that we are inserting
-    * @return index to insert
+    * @param slot - index in pageNoArray of the child that was split; it keeps the left half
+    * @param newChild - right half of the split child
+    * @param nLeaf - non leaf node we are inserting key into
   */
-     int findInsertPlaceNonLeaf(int *key, NonLeafNodeInt *nLeaf);
+     template <class T>
+     void insertNonLeaf(const T &key, const int slot, PageId newChild, NonLeafNode<T> *nLeaf);
 
   /**
-    * Inserts key into leaf
+    * prints out the whole dang tree when node = root
+  */
+     template <class T>
+     void printTree(NonLeafNode<T>* node);
+
+  /**
+    * prints out the nonleafNode
+  */
+     template <class T>
+     void printNonLeafNode(NonLeafNode<T>* node);
+
+  /**
+    * Splits a full leaf plus one new entry in place; leafNode keeps the left
+    * half and a new right sibling is allocated for the rest
+    * @param leafNode - full leaf
     * @param key - key that we are inserting
     * @param rid - record id that we are inserting
-    * @param leaf - leaf node we are inserting key and rid into
+    * @param sLeafNo - returns page number of right leaf
+    * @param pushUp - returns key to insert into the parent
   */
-     void insertNonLeaf(int *key, PageId fLeafNo, PageId sLeafNo, NonLeafNodeInt *nLeaf);
-     
+    template <class T>
+    void splitLeafArrays(LeafNode<T> *leafNode, const T &key, const RecordId rid, PageId &sLeafNo, T &pushUp);
 
   /**
-    * retrieves the root leaf node when the root is the only node
-    * @param getLeaf - pointer to the leaf node we retrieved
-    * @param rootNode - root Node leaf is connected to
-    * @return pageNo of the leaf node
+    * Splits a full non leaf node plus one new key and child in place; node
+    * keeps the left half and a new right sibling is allocated for the rest
+    * @param node - full node
+    * @param key - key that we are inserting
+    * @param slot - index in pageNoArray of the child that was split, left child of key
+    * @param newChild - right child of key
+    * @param snLeafNo - returns page number of right node
+    * @param pushUp - returns key to insert into the parent
   */
-    PageId getInitLeaf(LeafNodeInt *getLeaf, NonLeafNodeInt *rootNode, Page*& realRoot);
+    template <class T>
+    void splitNonLeafArrays(NonLeafNode<T> *node, const T &key, const int slot, PageId newChild, PageId &snLeafNo, T &pushUp);
+
+    template <class T>
+    void splitRoot(const int slot, PageId newChild, NonLeafNode<T> *root, const T &key);
+
+    template <class T>
+    void splitNonLeafNode(const int slot, PageId newChild, PageId oldNode, NonLeafNode<T> *currNode, TreePath &path, const T &key);
+
+    template <class T>
+    void splitLeaf(LeafNode<T> *leaf, PageId oldLeaf, TreePath &path, const T &key, RecordId rid);
 
   /**
-    * prints out the whole dang tree when node = root
+    * Finds the path from the root to the leaf key belongs in
+    * @param path - filled with the pages from the root down; leaf ends up on top
+    * @param key - key we are looking for
+    * @param leftmost - descend to the leftmost leaf that may hold key, as a scan does,
+    *                   rather than the leaf key is inserted into
   */
-     void printTree(NonLeafNodeInt* node);
+    template <class T>
+    void findPath(TreePath &path, const T &key, bool leftmost = false);
 
   /**
-    * prints out the nonleafNode
+    * Inserts a key of the index's type; see insertEntry
+  */
+    template <class T>
+    void insertKey(const T &key, const RecordId rid);
+
+  /**
+    * Inserts into the leaf the last insert went to, if the key belongs there
+    * and the leaf has room. A leaf holds every key from its first key on when it
+    * is the rightmost leaf, or up to its last key otherwise
+    * @param key - key to insert
+    * @param rid - record id of the entry
+    * @return true if the entry was inserted
+  */
+    template <class T>
+    bool insertAtHint(const T &key, const RecordId rid);
+
+  /**
+    * Deletes a key of the index's type; see deleteEntry
+  */
+    template <class T>
+    void deleteKey(const T &key, const RecordId rid);
+
+  /**
+    * Removes the entry from the leaf if it is there
+    * @param leafNo - page number of the leaf
+    * @param key - key of the entry
+    * @param rid - record id of the entry
+    * @param underfull - set if the leaf is underfull afterwards
+    * @return true if the entry was found
+  */
+    template <class T>
+    bool deleteFromLeaf(PageId leafNo, const T &key, const RecordId rid, bool &underfull);
+
+  /**
+    * Removes the entry from the subtree rooted at the node and rebalances
+    * the child it was removed from if that child became underfull
+    * @param nodeNo - page number of the non leaf node
+    * @param key - key of the entry
+    * @param rid - record id of the entry
+    * @param underfull - set if the node is underfull afterwards
+    * @return true if the entry was found
   */
-     void printNonLeafNode(NonLeafNodeInt* node);
+    template <class T>
+    bool deleteFromNonLeaf(PageId nodeNo, const T &key, const RecordId rid, bool &underfull);
 
   /**
-    * finds out where to split leaf
+    * Root left with a single child after a merge hands the tree down to that child:
+    * a lone leaf goes back under a level 2 root, a lone non leaf child becomes the root
   */
-    int findInsertPlaceSplit(int *keyArray, int *key, bool isLeaf);
+    template <class T>
+    void collapseRoot();
 
-    void splitRoot(PageId fNextNode, PageId sNextNode, NonLeafNodeInt *root, int *intKey, bool level);
+  /**
+    * Compacts the index; see compact
+  */
+    template <class T>
+    void compactTree();
 
-    void splitNonLeafNode(PageId fNextNode, PageId sNextNode, PageId oldNode, NonLeafNodeInt *currNode, std::list <PageId> &path, bool firstLevel, int *intKey);
+  /**
+    * Compacts the subtree rooted at the node
+    * @param nodeNo - page number of the non leaf node
+    * @return true if the node is underfull afterwards
+  */
+    template <class T>
+    bool compactNode(PageId nodeNo);
 
-    void splitLeaf(LeafNodeInt *leaf, PageId oldLeaf, std::list <PageId> &path, int *key, RecordId rid);
+  /**
+    * Drops the tombstones of every leaf child of the node and merges each run of
+    * neighbours that fit in one leaf, writing every leaf at most once
+    * @param node - non leaf node right above the leaves
+    * @return true if node lost children
+  */
+    template <class T>
+    bool compactLeaves(NonLeafNode<T> *node);
 
-    void findPath(std::list <PageId> &path, int *key);
+  /**
+    * Merges the underfull leaf child at index with a sibling leaf if both fit in one,
+    * else evens out the entries of the two and updates the separator between them
+    * @param parent - parent of the leaves
+    * @param index - index of the underfull child in parent
+  */
+    template <class T>
+    void rebalanceLeaves(NonLeafNode<T> *parent, const int index);
 
-    void updateScanVars(Page *currPage, PageId currPageNo, LeafNodeInt *leafNode, int indexStart);
+  /**
+    * Same as rebalanceLeaves for non leaf children; the separator in parent
+    * moves down into the merged node or is replaced by the middle key
+    * @param parent - parent of the nodes
+    * @param index - index of the underfull child in parent
+  */
+    template <class T>
+    void rebalanceNonLeaves(NonLeafNode<T> *parent, const int index);
+
+  /**
+    * Finds the entries of key without touching the scan; see lookup and exists
+    * @param key - key to look up
+    * @param outRids - record ids of the entries are appended here; if NULL the
+    * search stops at the first entry
+    * @return true if the index holds key
+  */
+    template <class T>
+    bool lookupKey(const T &key, std::vector<RecordId> *outRids);
+
+  /**
+    * Collects the entries of key starting at leaf, which is pinned, and
+    * walking right while the key goes on
+    * @param key - key to look up
+    * @param leafNo - page number of leaf; set to the leaf the search ends on,
+    * which is left pinned
+    * @param leaf - leaf to start at; set to the leaf the search ends on
+    * @param outRids - record ids of the entries are appended here; if NULL the
+    * search stops at the first entry
+    * @return true if an entry with key was found
+  */
+    template <class T>
+    bool findLeafKey(const T &key, PageId &leafNo, Page *&leaf, std::vector<RecordId> *outRids);
+
+  /**
+    * Looks up the probe keys in one walk of the tree; see lookupBatch
+  */
+    template <class T>
+    void lookupBatchKeys(const void* const* keys, const int numKeys, std::vector< std::vector<RecordId> > &outRids);
+
+  /**
+    * Looks up count sorted probe keys in the subtree of nodeNo, which stays
+    * pinned while the probes under it are looked up
+    * @param nodeNo - page number of the non leaf node
+    * @param keys - sorted probe keys
+    * @param order - index in outRids of each probe key
+    * @param count - number of probe keys
+    * @param outRids - record ids found for each probe
+    * @param leafNo - page number of the pinned leaf the last probe ended on, or 0
+    * @param leaf - that leaf
+  */
+    template <class T>
+    void lookupBatchNode(PageId nodeNo, const T *keys, const int *order, const int count, std::vector< std::vector<RecordId> > &outRids, PageId &leafNo, Page *&leaf);
+
+  /**
+    * Positions the scan on the first entry in range; see startScan
+  */
+    template <class T>
+    void startScanKey(const T &lowVal, const Operator lowOp, const T &highVal, const Operator highOp);
+
+  /**
+    * Returns the next entry of the scan; see scanNext
+  */
+    template <class T>
+    void scanNextKey(RecordId &outRid);
+
+  /**
+    * Stores the low and high value of the scan in the members for the index's type
+  */
+    void setScanRange(const int &lowVal, const int &highVal);
+    void setScanRange(const double &lowVal, const double &highVal);
+    void setScanRange(const StringKey &lowVal, const StringKey &highVal);
+
+  /**
+    * Low and high value of the scan, as keys of the index's type
+  */
+    void getScanRange(int &lowVal, int &highVal) const;
+    void getScanRange(double &lowVal, double &highVal) const;
+    void getScanRange(StringKey &lowVal, StringKey &highVal) const;
+
+  /**
+    * returns the index of the first entry of leafNode past the scan's low bound
+  */
+    template <class T>
+    int findScanStart(LeafNode<T> *leafNode);
+
+    template <class T>
+    void updateScanVars(Page *currPage, PageId currPageNo, LeafNode<T> *leafNode, int indexStart);
 
  public:
 
@@ -437,10 +1144,18 @@ base relation using FileScan class.
    * @param bufMgrIn						Buffer Manager Instance
    * @param attrByteOffset			Offset of attribute, over which index is to be built, in the record
    * @param attrType						Datatype of attribute over which index is built
+   * @param fillFactor					Fraction of each node filled when a new index is bulk loaded
+   * @param runSize						Number of key-rid pairs sorted in memory per run when a new index is bulk loaded
+   * @param leafFormat					Format of the INTEGER or DOUBLE leaves of a new index; POSTING_LEAF pays off when keys repeat
+   * @param ringSize						Frames of the ring a new index is bulk loaded through, so that scanning the relation leaves the rest of the pool alone; 0 reads the relation through the whole pool
    * @throws  BadIndexInfoException     If the index file already exists for the corresponding attribute, but values in metapage(relationName, attribute byte offset, attribute type etc.) do not match with values received through constructor parameters.
    */
 	BTreeIndex(const std::string & relationName, std::string & outIndexName,
-						BufMgr *bufMgrIn,	const int attrByteOffset,	const Datatype attrType);
+						BufMgr *bufMgrIn,	const int attrByteOffset,	const Datatype attrType,
+						const double fillFactor = BULKLOAD_FILLFACTOR,
+						const int runSize = BULKLOAD_RUNSIZE,
+						const LeafFormat leafFormat = PLAIN_LEAF,
+						const std::uint32_t ringSize = BufRing::DEFAULT_SIZE);
 	
 
   /**
@@ -464,6 +1179,76 @@ base relation using FileScan class.
 	const void insertEntry(const void* key, const RecordId rid);
 
 
+  /**
+	 * Delete the entry <value,rid>.
+	 * Start from root to find the leaf holding the entry; with duplicate keys every leaf that may hold the key is searched.
+	 * A leaf left less than half full borrows entries from a sibling or is merged into it, and the parent loses the
+	 * separator of a merged node, which may in-turn become underfull. Pages emptied by a merge are disposed of.
+	 * If the root is left with a single child, that child becomes the new root and the metapage is updated.
+	 * Must not be called while a scan is executing.
+   * @param key			Key to delete, pointer to integer/double/char string
+   * @param rid			Record ID of the record whose entry is getting deleted from the index.
+	 * @throws  NoSuchKeyFoundException If the index holds no entry <value,rid>.
+	**/
+	const void deleteEntry(const void* key, const RecordId rid);
+
+
+  /**
+	 * Choose how deleteEntry removes entries. With LAZY_DELETE an entry is only marked as a tombstone in its leaf,
+	 * so a delete writes one leaf and never restructures the tree. Scans skip tombstones, inserts into a full leaf
+	 * drop them before splitting, and compact() removes the rest and merges the leaves left underfull.
+   * @param mode		EAGER_DELETE (the default) or LAZY_DELETE
+	**/
+	const void setDeleteMode(const DeleteMode mode);
+
+
+  /**
+	 * Drop all tombstones and merge underfull nodes with their neighbours, bottom up. Meant to be run
+	 * every so often when the index is idle, after lazy deletes have accumulated; every leaf is written
+	 * at most once. If the root is left with a single child, that child becomes the new root.
+	 * Must not be called while a scan is executing.
+	**/
+	const void compact();
+
+
+  /**
+	 * Write every dirty page of the index to disk. Splits, deletes and scans only mark pages dirty and leave
+	 * them in the buffer pool; this is the explicit point at which the index file is brought up to date.
+	 * Must not be called while a scan is executing.
+	 * @throws  PagePinnedException If a page of the index is still pinned
+	**/
+	const void checkpoint();
+
+
+  /**
+	 * Find every entry with the given key. Unlike an equality scan this leaves the scan state alone and does not
+	 * throw when the key is missing: the tree is descended once and only the leaves holding the key are pinned,
+	 * one at a time. Can be called while a scan is executing.
+   * @param key			Key to look up, pointer to integer/double/char string
+   * @param outRids	Record ids of the entries with key are appended to this
+	**/
+	const void lookup(const void* key, std::vector<RecordId> &outRids);
+
+
+  /**
+	 * Check whether the index holds an entry with the given key. Same as lookup, stopping at the first entry.
+   * @param key			Key to look up, pointer to integer/double/char string
+	 * @return true if an entry with key exists
+	**/
+	const bool exists(const void* key);
+
+
+  /**
+	 * Look up many keys at once, as a join probing the index does. The keys are sorted and the tree is walked once
+	 * for all of them: each non leaf node is read once for all the keys below it, and a leaf stays pinned while
+	 * the following keys land on it. Leaves the scan state alone, like lookup.
+   * @param keys		Keys to look up, pointers to integer/double/char string
+   * @param numKeys	Number of keys
+   * @param outRids	Resized to numKeys; outRids[i] gets the record ids of the entries with keys[i]
+	**/
+	const void lookupBatch(const void* const* keys, const int numKeys, std::vector< std::vector<RecordId> > &outRids);
+
+
   /**
 	 * Begin a filtered scan of the index.  For instance, if the method is called 
 	 * using ("a",GT,"d",LTE) then we should seek all entries with a value 
@@ -15,100 +15,81 @@
 
 namespace badgerdb {
 
-int BufHashTbl::hash(const File* file, const PageId pageNo)
-{
-  int tmp, value;
-  tmp = (long)file;  // cast of pointer to the file object to an integer
-  value = (tmp + pageNo) % HTSIZE;
-  return value;
-}
-
 BufHashTbl::BufHashTbl(int htSize)
-	: HTSIZE(htSize)
+	: HTSIZE(2), hashShift(63), numEntries(0)
 {
-  // allocate an array of pointers to hashBuckets
-  ht = new hashBucket* [htSize];
-  for(int i=0; i < HTSIZE; i++)
-    ht[i] = NULL;
+  // keep the table under half full so that probe runs stay short
+  while (HTSIZE < 2 * (std::uint32_t)htSize)
+  {
+    HTSIZE *= 2;
+    hashShift--;
+  }
+
+  ht = new hashBucket[HTSIZE];
+  for(std::uint32_t i = 0; i < HTSIZE; i++)
+    ht[i].file = NULL;
 }
 
 BufHashTbl::~BufHashTbl()
 {
-  for(int i = 0; i < HTSIZE; i++) {
-    hashBucket* tmpBuf = ht[i];
-    while (ht[i]) {
-      tmpBuf = ht[i];
-      ht[i] = ht[i]->next;
-      delete tmpBuf;
-    }
-  }
   delete [] ht;
 }
 
 void BufHashTbl::insert(const File* file, const PageId pageNo, const FrameId frameNo)
 {
-  int index = hash(file, pageNo);
+  // one entry always stays empty, which ends every probe run
+  if (numEntries + 1 >= HTSIZE)
+  	throw HashTableException();
 
-  hashBucket* tmpBuc = ht[index];
-  while (tmpBuc) {
-    if (tmpBuc->file == file && tmpBuc->pageNo == pageNo)
-  		throw HashAlreadyPresentException(tmpBuc->file->filename(), tmpBuc->pageNo, tmpBuc->frameNo);
-    tmpBuc = tmpBuc->next;
+  std::uint32_t index = hash(file, pageNo);
+  while (ht[index].file) {
+    if (ht[index].file == file && ht[index].pageNo == pageNo)
+  		throw HashAlreadyPresentException(ht[index].file->filename(), ht[index].pageNo, ht[index].frameNo);
+    index = (index + 1) & (HTSIZE - 1);
   }
 
-  tmpBuc = new hashBucket;
-  if (!tmpBuc)
-  	throw HashTableException();
-
-  tmpBuc->file = (File*) file;
-  tmpBuc->pageNo = pageNo;
-  tmpBuc->frameNo = frameNo;
-  tmpBuc->next = ht[index];
-  ht[index] = tmpBuc;
+  ht[index].file = (File*) file;
+  ht[index].pageNo = pageNo;
+  ht[index].frameNo = frameNo;
+  numEntries++;
 }
 
 void BufHashTbl::lookup(const File* file, const PageId pageNo, FrameId &frameNo) 
 {
-  int index = hash(file, pageNo);
-  hashBucket* tmpBuc = ht[index];
-  while (tmpBuc) {
-    if (tmpBuc->file == file && tmpBuc->pageNo == pageNo)
-    {
-      frameNo = tmpBuc->frameNo; // return frameNo by reference
-      return;
-    }
-    tmpBuc = tmpBuc->next;
-  }
+  if (find(file, pageNo, frameNo))
+    return;
 
   throw HashNotFoundException(file->filename(), pageNo);
 }
 
 void BufHashTbl::remove(const File* file, const PageId pageNo) {
 
-  int index = hash(file, pageNo);
-  hashBucket* tmpBuc = ht[index];
-  hashBucket* prevBuc = NULL;
+  std::uint32_t index = hash(file, pageNo);
+  while (ht[index].file && !(ht[index].file == file && ht[index].pageNo == pageNo))
+    index = (index + 1) & (HTSIZE - 1);
 
-  while (tmpBuc)
+  if (!ht[index].file)
+    throw HashNotFoundException(file->filename(), pageNo);
+
+  // close the hole by moving back every later entry of the run that may not
+  // sit between its home slot and the hole
+  std::uint32_t next = index;
+  while (true)
 	{
-    if (tmpBuc->file == file && tmpBuc->pageNo == pageNo)
-		{
-      if(prevBuc) 
-				prevBuc->next = tmpBuc->next;
-      else
-				ht[index] = tmpBuc->next;
+    next = (next + 1) & (HTSIZE - 1);
+    if (!ht[next].file)
+      break;
 
-      delete tmpBuc;
-      return;
-    }
-		else
+    std::uint32_t home = hash(ht[next].file, ht[next].pageNo);
+    if (((next - home) & (HTSIZE - 1)) >= ((next - index) & (HTSIZE - 1)))
 		{
-      prevBuc = tmpBuc;
-      tmpBuc = tmpBuc->next;
+      ht[index] = ht[next];
+      index = next;
     }
   }
 
-  throw HashNotFoundException(file->filename(), pageNo);
+  ht[index].file = NULL;
+  numEntries--;
 }
 
 }
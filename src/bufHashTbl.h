@@ -7,12 +7,14 @@
 
 #pragma once
 
+#include <stdint.h>
 #include "file.h"
 
 namespace badgerdb {
 
 /**
-* @brief Declarations for buffer pool hash table
+* @brief Declarations for buffer pool hash table entries, stored in place in
+* the table.  An entry with a NULL file is empty.
 */
 struct hashBucket {
 	/**
@@ -29,43 +31,64 @@ struct hashBucket {
 	 * frame number of page in the buffer pool
 	 */
 	FrameId frameNo;
-
-	/**
-	 * Next node in the hash table
-	 */
-	hashBucket*   next;
 };
 
 
 /**
 * @brief Hash table class to keep track of pages in the buffer pool
 *
+* Open addressing with linear probing over a flat array of entries, which is
+* allocated once in the constructor.  Removal shifts the rest of the probe run
+* back instead of leaving tombstones, so lookups stop at the first empty entry.
+*
 * @warning This class is not threadsafe.
 */
 class BufHashTbl
 {
  private:
 	/**
-	 *	Size of Hash Table
+	 *	Size of Hash Table, a power of two
+	 */
+  std::uint32_t HTSIZE;
+
+	/**
+	 *	64 minus log2 of HTSIZE, the shift that leaves a hash value
 	 */
-  int HTSIZE;
+  std::uint32_t hashShift;
+
+	/**
+	 *	Number of entries in use
+	 */
+  std::uint32_t numEntries;
+
 	/**
 	 * Actual Hash table object
 	 */
-  hashBucket**  ht;
+  hashBucket*  ht;
 
 	/**
-	 * returns hash value between 0 and HTSIZE-1 computed using file and pageNo
+	 * returns hash value between 0 and HTSIZE-1 computed using file and pageNo.
+	 * Fibonacci hashing: the top bits of the product depend on all the low bits
+	 * of the key, so aligned File pointers don't cluster, and dense page numbers
+	 * of one file spread evenly.  The file is scrambled on its own first so that two
+	 * files a few bytes apart don't collide on every page.
 	 *
 	 * @param file   	File object
 	 * @param pageNo  Page number in the file
 	 * @return  			Hash value.
 	 */
-  int	 hash(const File* file, const PageId pageNo);
+  std::uint32_t hash(const File* file, const PageId pageNo) const
+  {
+    const std::uint64_t golden = 0x9e3779b97f4a7c15ULL;
+    return (((std::uint64_t)(uintptr_t)file * golden + pageNo) * golden) >> hashShift;
+  }
 
  public:
 	/**
    * Constructor of BufHashTbl class
+	 *
+	 * @param htSize  Number of entries the table is sized for; it holds at least
+	 *                that many at under half load
 	 */
 	BufHashTbl(const int htSize);  // constructor
 
@@ -81,12 +104,34 @@ class BufHashTbl
 	 * @param pageNo 	Page number in the file
 	 * @param frameNo Frame number assigned to that page of the file
    * @throws  HashAlreadyPresentException	if the corresponding page already exists in the hash table
-   * @throws  HashTableException (optional) if could not create a new bucket as running of memory
+   * @throws  HashTableException if the table is full
 	 */
   void insert(const File* file, const PageId pageNo, const FrameId frameNo);
 
 	/**
    * Check if (file, pageNo) is currently in the buffer pool (ie. in
+   * the hash table) without throwing, so that a miss is just a branch.
+	 *
+	 * @param file  	File object
+	 * @param pageNo	Page number in the file
+	 * @param frameNo Frame number reference, set only if the page is found
+	 * @return  			True if the page entry is in the hash table
+	 */
+  bool find(const File* file, const PageId pageNo, FrameId &frameNo) const
+  {
+    for (std::uint32_t i = hash(file, pageNo); ht[i].file != NULL; i = (i + 1) & (HTSIZE - 1))
+    {
+      if (ht[i].file == file && ht[i].pageNo == pageNo)
+      {
+        frameNo = ht[i].frameNo;
+        return true;
+      }
+    }
+    return false;
+  }
+
+	/**
+   * Check if (file, pageNo) is currently in the buffer pool (ie. in
    * the hash table).
 	 *
 	 * @param file  	File object
@@ -0,0 +1,488 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <algorithm>
+#include "bufPolicy.h"
+
+namespace badgerdb {
+
+BufPolicy* BufPolicy::create(const BufPolicyType type, const std::uint32_t numBufs)
+{
+  switch (type)
+  {
+    case LRUK_POLICY:
+      return new LRUKPolicy(numBufs);
+    case TWOQ_POLICY:
+      return new TwoQPolicy(numBufs);
+    case ARC_POLICY:
+      return new ARCPolicy(numBufs);
+    case CLOCK_POLICY:
+    default:
+      return new ClockPolicy(numBufs);
+  }
+}
+
+//----------------------------------------
+// ClockPolicy
+//----------------------------------------
+
+ClockPolicy::ClockPolicy(const std::uint32_t numBufs)
+	: numBufs(numBufs), clockHand(0)
+{
+  refbits = new std::atomic<bool>[numBufs];
+  for (FrameId i = 0; i < numBufs; i++)
+  {
+    refbits[i] = false;
+  }
+}
+
+ClockPolicy::~ClockPolicy()
+{
+  delete [] refbits;
+}
+
+void ClockPolicy::access(const FrameId frame)
+{
+  // only store when the bit is clear, so hits on hot pages don't keep
+  // taking the cache line from other cores
+  if (!refbits[frame].load(std::memory_order_relaxed))
+    refbits[frame].store(true, std::memory_order_relaxed);
+}
+
+void ClockPolicy::admit(const FrameId frame, const File* file, const PageId pageNo)
+{
+  refbits[frame].store(true, std::memory_order_relaxed);
+}
+
+void ClockPolicy::remove(const FrameId frame)
+{
+  refbits[frame].store(false, std::memory_order_relaxed);
+}
+
+bool ClockPolicy::victim(FrameId& frame, const Claim& claim)
+{
+  for (std::uint32_t numScanned = 0; numScanned < 2*numBufs; numScanned++)	//Need to scn twice
+  {
+    // advance the clock
+    FrameId hand = clockHand.fetch_add(1) % numBufs;
+
+    // has been referenced, clear the bit
+    if (refbits[hand].load(std::memory_order_relaxed))
+    {
+      refbits[hand].store(false, std::memory_order_relaxed);
+      continue;
+    }
+
+    if (claim(hand))
+    {
+      frame = hand;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+//----------------------------------------
+// BatchedPolicy
+//----------------------------------------
+
+const std::uint32_t BatchedPolicy::NUMSTRIPES;
+const std::uint32_t BatchedPolicy::STRIPESIZE;
+
+BatchedPolicy::BatchedPolicy()
+{
+  for (std::uint32_t i = 0; i < NUMSTRIPES; i++)
+  {
+    stripes[i].count = 0;
+  }
+}
+
+void BatchedPolicy::access(const FrameId frame)
+{
+  Stripe& stripe = stripes[frame % NUMSTRIPES];
+
+  // without contention the access is applied at once, after any the stripe
+  // logged before it
+  std::unique_lock<std::mutex> guard(latch, std::try_to_lock);
+  if (guard.owns_lock())
+  {
+    if (stripe.count.load(std::memory_order_relaxed) != 0)
+    {
+      std::unique_lock<std::mutex> stripeGuard(stripe.latch, std::try_to_lock);
+      if (stripeGuard.owns_lock())
+        applyStripe(stripe);
+    }
+    applyAccess(frame);
+    return;
+  }
+
+  std::lock_guard<std::mutex> stripeGuard(stripe.latch);
+  std::uint32_t count = stripe.count.load(std::memory_order_relaxed);
+  stripe.frames[count++] = frame;
+  stripe.count.store(count, std::memory_order_relaxed);
+  if (count < STRIPESIZE)
+    return;
+
+  guard.lock();
+  applyStripe(stripe);
+}
+
+void BatchedPolicy::applyStripe(Stripe& stripe)
+{
+  std::uint32_t count = stripe.count.load(std::memory_order_relaxed);
+  for (std::uint32_t i = 0; i < count; i++)
+  {
+    applyAccess(stripe.frames[i]);
+  }
+  stripe.count.store(0, std::memory_order_relaxed);
+}
+
+void BatchedPolicy::drainLog()
+{
+  // hits take a stripe's latch before the policy's, so only try it here
+  for (std::uint32_t i = 0; i < NUMSTRIPES; i++)
+  {
+    std::unique_lock<std::mutex> stripeGuard(stripes[i].latch, std::try_to_lock);
+    if (stripeGuard.owns_lock())
+      applyStripe(stripes[i]);
+  }
+}
+
+//----------------------------------------
+// FrameLists
+//----------------------------------------
+
+const std::uint8_t FrameLists::NONE;
+
+FrameLists::FrameLists(const std::uint32_t numBufs, const std::uint8_t numLists)
+	: next(numBufs + numLists), prev(numBufs + numLists), owner(numBufs, NONE), sizes(numLists, 0), numBufs(numBufs)
+{
+  // an empty list's head points at itself
+  for (std::uint32_t i = numBufs; i < numBufs + numLists; i++)
+  {
+    next[i] = prev[i] = i;
+  }
+}
+
+void FrameLists::pushBack(const std::uint8_t list, const FrameId frame)
+{
+  unlink(frame);
+
+  FrameId head = numBufs + list;
+  next[frame] = head;
+  prev[frame] = prev[head];
+  next[prev[head]] = frame;
+  prev[head] = frame;
+
+  owner[frame] = list;
+  sizes[list]++;
+}
+
+void FrameLists::unlink(const FrameId frame)
+{
+  if (owner[frame] == NONE)
+    return;
+
+  next[prev[frame]] = next[frame];
+  prev[next[frame]] = prev[frame];
+
+  sizes[owner[frame]]--;
+  owner[frame] = NONE;
+}
+
+//----------------------------------------
+// GhostList
+//----------------------------------------
+
+bool GhostList::erase(const PageKey& key)
+{
+  std::unordered_map<PageKey, std::list<PageKey>::iterator, PageKeyHash>::iterator it = index.find(key);
+  if (it == index.end())
+    return false;
+
+  order.erase(it->second);
+  index.erase(it);
+  return true;
+}
+
+void GhostList::pushBack(const PageKey& key)
+{
+  erase(key);
+  order.push_back(key);
+  index[key] = --order.end();
+}
+
+void GhostList::popFront()
+{
+  index.erase(order.front());
+  order.pop_front();
+}
+
+//----------------------------------------
+// LRUKPolicy
+//----------------------------------------
+
+LRUKPolicy::LRUKPolicy(const std::uint32_t numBufs, const std::uint32_t k)
+	: K(k), now(0), history(numBufs * k), counts(numBufs, 0), cold(numBufs, 1), hotKeys(numBufs, 0)
+{
+}
+
+void LRUKPolicy::fileHot(const FrameId frame)
+{
+  hotKeys[frame] = kthAccess(frame);
+  hot.insert(std::make_pair(hotKeys[frame], frame));
+}
+
+void LRUKPolicy::record(const FrameId frame)
+{
+  history[frame * K + counts[frame] % K] = now++;
+  counts[frame]++;
+}
+
+void LRUKPolicy::applyAccess(const FrameId frame)
+{
+  // the frame has no page, or has lost it since the access was logged
+  if (counts[frame] == 0)
+    return;
+
+  // a hot frame's K-th access only moves later, so it stays filed under the
+  // old one until victim() comes across it
+  record(frame);
+  if (counts[frame] == K)
+  {
+    cold.unlink(frame);
+    fileHot(frame);
+  }
+}
+
+void LRUKPolicy::admit(const FrameId frame, const File* file, const PageId pageNo)
+{
+  std::lock_guard<std::mutex> guard(latch);
+
+  counts[frame] = 0;
+  record(frame);
+  if (counts[frame] == K)
+    fileHot(frame);
+  else
+    cold.pushBack(COLD, frame);
+}
+
+void LRUKPolicy::remove(const FrameId frame)
+{
+  std::lock_guard<std::mutex> guard(latch);
+
+  if (counts[frame] >= K)
+    hot.erase(std::make_pair(hotKeys[frame], frame));
+  else
+    cold.unlink(frame);
+
+  counts[frame] = 0;
+}
+
+bool LRUKPolicy::victim(FrameId& frame, const Claim& claim)
+{
+  std::lock_guard<std::mutex> guard(latch);
+  drainLog();
+
+  // frames without K accesses have an infinite K-distance; the one accessed
+  // longest ago goes first
+  for (FrameId i = cold.begin(COLD); i != cold.end(COLD); i = cold.after(i))
+  {
+    if (claim(i))
+    {
+      cold.unlink(i);
+      counts[i] = 0;
+      frame = i;
+      return true;
+    }
+  }
+
+  std::set< std::pair<std::uint64_t, FrameId> >::iterator it = hot.begin();
+  while (it != hot.end())
+  {
+    // refile a frame accessed since it was filed; it comes up again at once
+    // if it still goes before the frames after it
+    FrameId f = it->second;
+    if (it->first != kthAccess(f))
+    {
+      it = hot.erase(it);
+      hotKeys[f] = kthAccess(f);
+      std::set< std::pair<std::uint64_t, FrameId> >::iterator filed = hot.insert(std::make_pair(hotKeys[f], f)).first;
+      if (it == hot.end() || *filed < *it)
+        it = filed;
+      continue;
+    }
+
+    if (claim(f))
+    {
+      frame = f;
+      hot.erase(it);
+      counts[frame] = 0;
+      return true;
+    }
+    ++it;
+  }
+
+  return false;
+}
+
+//----------------------------------------
+// TwoQPolicy
+//----------------------------------------
+
+TwoQPolicy::TwoQPolicy(const std::uint32_t numBufs)
+	: kin(std::max(1u, numBufs / 4)), kout(std::max(1u, numBufs / 2)), pages(numBufs), lists(numBufs, 2)
+{
+}
+
+void TwoQPolicy::applyAccess(const FrameId frame)
+{
+  // a second access while in A1in is most likely the same operation
+  // touching the page again, so only pages in Am move
+  if (lists.listOf(frame) == AM)
+    lists.pushBack(AM, frame);
+}
+
+void TwoQPolicy::admit(const FrameId frame, const File* file, const PageId pageNo)
+{
+  std::lock_guard<std::mutex> guard(latch);
+
+  PageKey key = {file, pageNo};
+  pages[frame] = key;
+  lists.pushBack(a1out.erase(key) ? AM : A1IN, frame);
+}
+
+void TwoQPolicy::remove(const FrameId frame)
+{
+  std::lock_guard<std::mutex> guard(latch);
+  lists.unlink(frame);
+}
+
+bool TwoQPolicy::victim(FrameId& frame, const Claim& claim)
+{
+  std::lock_guard<std::mutex> guard(latch);
+  drainLog();
+
+  // A1in gives up frames once it is over its share, Am otherwise, and each
+  // falls back on the other when all its frames are pinned
+  std::uint8_t order[2] = {AM, A1IN};
+  if (lists.size(A1IN) > kin)
+    std::swap(order[0], order[1]);
+
+  for (int i = 0; i < 2; i++)
+  {
+    std::uint8_t list = order[i];
+    for (FrameId f = lists.begin(list); f != lists.end(list); f = lists.after(f))
+    {
+      if (!claim(f))
+        continue;
+
+      lists.unlink(f);
+      if (list == A1IN)
+      {
+        a1out.pushBack(pages[f]);
+        if (a1out.size() > kout)
+          a1out.popFront();
+      }
+
+      frame = f;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+//----------------------------------------
+// ARCPolicy
+//----------------------------------------
+
+ARCPolicy::ARCPolicy(const std::uint32_t numBufs)
+	: numBufs(numBufs), p(0), pages(numBufs), lists(numBufs, 2)
+{
+}
+
+void ARCPolicy::applyAccess(const FrameId frame)
+{
+  if (lists.listOf(frame) != FrameLists::NONE)
+    lists.pushBack(T2, frame);
+}
+
+void ARCPolicy::admit(const FrameId frame, const File* file, const PageId pageNo)
+{
+  std::lock_guard<std::mutex> guard(latch);
+
+  PageKey key = {file, pageNo};
+  pages[frame] = key;
+
+  // a page remembered in B1 would have stayed with a larger T1, and one in B2
+  // with a larger T2; move the target by more the rarer such returns are
+  std::uint32_t b1Size = b1.size();
+  std::uint32_t b2Size = b2.size();
+
+  if (b1.erase(key))
+  {
+    p = std::min(numBufs, p + std::max(b2Size / b1Size, 1u));
+    lists.pushBack(T2, frame);
+    return;
+  }
+
+  if (b2.erase(key))
+  {
+    std::uint32_t delta = std::max(b1Size / b2Size, 1u);
+    p = p > delta ? p - delta : 0;
+    lists.pushBack(T2, frame);
+    return;
+  }
+
+  lists.pushBack(T1, frame);
+
+  // T1 and B1 together remember at most a pool of pages, and all four lists
+  // at most two
+  while (lists.size(T1) + b1.size() > numBufs && b1.size() > 0)
+    b1.popFront();
+  while (lists.size(T1) + lists.size(T2) + b1.size() + b2.size() > 2 * numBufs && b2.size() > 0)
+    b2.popFront();
+}
+
+void ARCPolicy::remove(const FrameId frame)
+{
+  std::lock_guard<std::mutex> guard(latch);
+  lists.unlink(frame);
+}
+
+bool ARCPolicy::victimFrom(const std::uint8_t list, GhostList& ghost, FrameId& frame, const Claim& claim)
+{
+  for (FrameId f = lists.begin(list); f != lists.end(list); f = lists.after(f))
+  {
+    if (claim(f))
+    {
+      lists.unlink(f);
+      ghost.pushBack(pages[f]);
+      frame = f;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool ARCPolicy::victim(FrameId& frame, const Claim& claim)
+{
+  std::lock_guard<std::mutex> guard(latch);
+  drainLog();
+
+  // the page coming in isn't known yet, so a T1 exactly at its target keeps
+  // its frames
+  if (lists.size(T1) > 0 && lists.size(T1) > p)
+    return victimFrom(T1, b1, frame, claim) || victimFrom(T2, b2, frame, claim);
+
+  return victimFrom(T2, b2, frame, claim) || victimFrom(T1, b1, frame, claim);
+}
+
+}
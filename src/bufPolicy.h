@@ -0,0 +1,493 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "file.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Replacement policies a BufMgr can be built with
+ */
+enum BufPolicyType
+{
+	CLOCK_POLICY,
+	LRUK_POLICY,
+	TWOQ_POLICY,
+	ARC_POLICY
+};
+
+
+/**
+* @brief Decides which frame of the buffer pool to replace
+*
+* The buffer manager tells the policy when a frame takes a page, when a page in
+* a frame is accessed again and when a frame is emptied without being
+* replaced, and asks it for a frame to replace when the pool is full.  Frames
+* on the buffer manager's free list are unknown to the policy.
+*
+* access, admit and remove are called with the latch of the shard mapping the
+* frame's page held.  Policies must be safe to call from many threads at once.
+* access is called on every hit, so it must not make hits on different shards
+* wait for each other; CLOCK only sets a bit, and the others log accesses and
+* apply them in batches (see BatchedPolicy).
+*/
+class BufPolicy
+{
+ public:
+	/**
+	 * Called by victim() on candidate frames, best first.  Returns true if the
+	 * buffer manager took the frame, false if the frame is pinned or busy.  Must
+	 * not call back into the policy.
+	 */
+  typedef std::function<bool(const FrameId)> Claim;
+
+	/**
+   * Creates a policy of the given type for a pool of numBufs frames
+	 *
+	 * @param type  	Policy to create
+	 * @param numBufs	Number of frames in the buffer pool
+	 * @return  			New policy, owned by the caller
+	 */
+  static BufPolicy* create(const BufPolicyType type, const std::uint32_t numBufs);
+
+  virtual ~BufPolicy() {}
+
+	/**
+   * Name of the policy, for printing
+	 */
+  virtual const char* name() const = 0;
+
+	/**
+   * A page already in the frame was pinned again
+	 *
+	 * @param frame   	Frame ID
+	 */
+  virtual void access(const FrameId frame) = 0;
+
+	/**
+   * The frame took a page, either read in or newly allocated
+	 *
+	 * @param frame   	Frame ID
+	 * @param file   		File object
+	 * @param pageNo  	Page number in the file
+	 */
+  virtual void admit(const FrameId frame, const File* file, const PageId pageNo) = 0;
+
+	/**
+   * The frame's page left the pool without being replaced, because it was
+   * flushed or disposed of.  Does nothing for frames the policy doesn't hold.
+	 *
+	 * @param frame   	Frame ID
+	 */
+  virtual void remove(const FrameId frame) = 0;
+
+	/**
+   * Offers frames to claim until it takes one, and forgets that frame
+	 *
+	 * @param frame   	Frame reference, the frame claimed is returned via this variable
+	 * @param claim   	Takes a frame for the buffer manager
+	 * @return  			False if no frame was claimed
+	 */
+  virtual bool victim(FrameId& frame, const Claim& claim) = 0;
+};
+
+
+/**
+* @brief One-bit CLOCK, as BufMgr always used.  Accesses only set a bit, so
+* hits take no latch.
+*/
+class ClockPolicy : public BufPolicy
+{
+ private:
+	/**
+   * Number of frames in the buffer pool
+	 */
+  std::uint32_t numBufs;
+
+	/**
+   * Current position of clockhand in our buffer pool; threads advance it
+   * together
+	 */
+  std::atomic<std::uint32_t> clockHand;
+
+	/**
+   * Has each frame been referenced since the hand last passed it
+	 */
+  std::atomic<bool>* refbits;
+
+ public:
+  ClockPolicy(const std::uint32_t numBufs);
+  ~ClockPolicy();
+
+  const char* name() const { return "CLOCK"; }
+  void access(const FrameId frame);
+  void admit(const FrameId frame, const File* file, const PageId pageNo);
+  void remove(const FrameId frame);
+  bool victim(FrameId& frame, const Claim& claim);
+};
+
+
+/**
+* @brief Base of policies whose state one latch guards.  A hit that finds the
+* latch taken appends its frame to a log stripe instead of waiting, and waits
+* only once the stripe is full, to apply all of it.  Under contention, hits
+* thus take the latch once per batch instead of once each, as in BP-Wrapper.
+* Stripes go by frame, so hits on different frames rarely share one.
+*
+* Logged accesses may be applied after their frame has been replaced, so
+* applyAccess must ignore frames the policy doesn't hold and may credit a
+* frame's new page with an access to its old one.
+*/
+class BatchedPolicy : public BufPolicy
+{
+ private:
+	/**
+   * Number of log stripes, and accesses each holds before a hit waits for the
+   * latch
+	 */
+  static const std::uint32_t NUMSTRIPES = 16;
+  static const std::uint32_t STRIPESIZE = 64;
+
+  struct Stripe
+  {
+    std::mutex latch;
+
+		/**
+     * Accesses logged; changed under the stripe's latch, and read without it
+     * to skip empty stripes
+		 */
+    std::atomic<std::uint32_t> count;
+    FrameId frames[STRIPESIZE];
+
+		/**
+     * Keeps neighbouring stripes off one cache line
+		 */
+    char padding[64];
+  };
+
+  Stripe stripes[NUMSTRIPES];
+
+	/**
+   * Applies the stripe's accesses, oldest first, and empties it.  Called
+   * with both latches held.
+	 */
+  void applyStripe(Stripe& stripe);
+
+ protected:
+	/**
+   * Guards the policy's state
+	 */
+  std::mutex latch;
+
+	/**
+   * Applies a logged access, with the latch held
+	 *
+	 * @param frame   	Frame ID
+	 */
+  virtual void applyAccess(const FrameId frame) = 0;
+
+	/**
+   * Applies the stripes no hit is appending to, so that victim() sees recent
+   * accesses.  Called with the latch held.
+	 */
+  void drainLog();
+
+ public:
+  BatchedPolicy();
+
+  void access(const FrameId frame);
+};
+
+
+/**
+* @brief Doubly linked lists threaded through arrays indexed by frame, so
+* moving a frame between lists allocates nothing.  Each frame is on at most
+* one list; lists are kept least recently used first.
+*/
+class FrameLists
+{
+ private:
+	/**
+   * Next and previous frame of each frame and of each list's head, which
+   * follow the frames at index numBufs + list
+	 */
+  std::vector<FrameId> next;
+  std::vector<FrameId> prev;
+
+	/**
+   * List each frame is on, or NONE
+	 */
+  std::vector<std::uint8_t> owner;
+
+	/**
+   * Length of each list
+	 */
+  std::vector<std::uint32_t> sizes;
+
+	/**
+   * Number of frames in the buffer pool
+	 */
+  std::uint32_t numBufs;
+
+ public:
+	/**
+   * List of a frame that is on none
+	 */
+  static const std::uint8_t NONE = 0xff;
+
+  FrameLists(const std::uint32_t numBufs, const std::uint8_t numLists);
+
+  std::uint8_t listOf(const FrameId frame) const { return owner[frame]; }
+  std::uint32_t size(const std::uint8_t list) const { return sizes[list]; }
+
+	/**
+   * First frame of the list, or end(list) if it is empty
+	 */
+  FrameId begin(const std::uint8_t list) const { return next[numBufs + list]; }
+  FrameId end(const std::uint8_t list) const { return numBufs + list; }
+  FrameId after(const FrameId frame) const { return next[frame]; }
+
+	/**
+   * Moves the frame to the most recently used end of the list, taking it off
+   * any list it is on
+	 */
+  void pushBack(const std::uint8_t list, const FrameId frame);
+
+	/**
+   * Takes the frame off its list, if any
+	 */
+  void unlink(const FrameId frame);
+};
+
+
+/**
+* @brief Identity of a page, for policies that remember pages no longer in the
+* pool.  The file pointer is only compared, never followed, so a stale entry
+* at most gives a page advice meant for another.
+*/
+struct PageKey
+{
+  const File* file;
+  PageId pageNo;
+
+  bool operator==(const PageKey& other) const
+  {
+    return file == other.file && pageNo == other.pageNo;
+  }
+};
+
+struct PageKeyHash
+{
+  std::size_t operator()(const PageKey& key) const
+  {
+    return (std::size_t)((((std::uint64_t)(uintptr_t)key.file * 0x9e3779b97f4a7c15ULL) + key.pageNo) * 0x9e3779b97f4a7c15ULL >> 32);
+  }
+};
+
+
+/**
+* @brief FIFO of pages recently replaced, with lookup by page
+*/
+class GhostList
+{
+ private:
+  std::list<PageKey> order;
+  std::unordered_map<PageKey, std::list<PageKey>::iterator, PageKeyHash> index;
+
+ public:
+  std::uint32_t size() const { return order.size(); }
+
+	/**
+   * Forgets the page if it is in the list
+	 *
+	 * @return  			True if it was
+	 */
+  bool erase(const PageKey& key);
+
+	/**
+   * Adds the page as the newest entry
+	 */
+  void pushBack(const PageKey& key);
+
+	/**
+   * Forgets the oldest entry
+	 */
+  void popFront();
+};
+
+
+/**
+* @brief LRU-K: replaces the frame whose K-th most recent access is oldest.
+* Frames accessed fewer than K times go first, oldest first, so a page read
+* once by a scan leaves before pages looked up again and again.
+*/
+class LRUKPolicy : public BatchedPolicy
+{
+ private:
+  enum { COLD = 0 };
+
+	/**
+   * Number of accesses kept per frame
+	 */
+  std::uint32_t K;
+
+	/**
+   * Logical time, advanced on every access
+	 */
+  std::uint64_t now;
+
+	/**
+   * Last K access times of each frame, as a ring
+	 */
+  std::vector<std::uint64_t> history;
+
+	/**
+   * Accesses of each frame since it took its page
+	 */
+  std::vector<std::uint32_t> counts;
+
+	/**
+   * Frames accessed fewer than K times, by first access
+	 */
+  FrameLists cold;
+
+	/**
+   * Frames accessed at least K times, by K-th most recent access as of when
+   * each was filed; hits leave a frame where it is, and victim() refiles it
+   * when it comes across it
+	 */
+  std::set< std::pair<std::uint64_t, FrameId> > hot;
+
+	/**
+   * Key each hot frame is filed under in hot
+	 */
+  std::vector<std::uint64_t> hotKeys;
+
+	/**
+   * Records an access to the frame at the current time
+	 */
+  void record(const FrameId frame);
+
+	/**
+   * Files a frame that has just reached K accesses in hot
+	 */
+  void fileHot(const FrameId frame);
+
+	/**
+   * K-th most recent access time of a frame accessed at least K times
+	 */
+  std::uint64_t kthAccess(const FrameId frame) const
+  {
+    return history[frame * K + counts[frame] % K];
+  }
+
+ protected:
+  void applyAccess(const FrameId frame);
+
+ public:
+  LRUKPolicy(const std::uint32_t numBufs, const std::uint32_t k = 2);
+
+  const char* name() const { return "LRU-2"; }
+  void admit(const FrameId frame, const File* file, const PageId pageNo);
+  void remove(const FrameId frame);
+  bool victim(FrameId& frame, const Claim& claim);
+};
+
+
+/**
+* @brief 2Q: pages enter a FIFO (A1in) and are promoted to an LRU list (Am)
+* only if they come back soon after leaving it, which A1out remembers.  A1in
+* gets a quarter of the pool and A1out remembers half a pool of pages.
+*/
+class TwoQPolicy : public BatchedPolicy
+{
+ private:
+  enum { A1IN = 0, AM = 1 };
+
+  std::uint32_t kin;
+  std::uint32_t kout;
+
+	/**
+   * Page in each frame, for A1out
+	 */
+  std::vector<PageKey> pages;
+
+  FrameLists lists;
+  GhostList a1out;
+
+ protected:
+  void applyAccess(const FrameId frame);
+
+ public:
+  TwoQPolicy(const std::uint32_t numBufs);
+
+  const char* name() const { return "2Q"; }
+  void admit(const FrameId frame, const File* file, const PageId pageNo);
+  void remove(const FrameId frame);
+  bool victim(FrameId& frame, const Claim& claim);
+};
+
+
+/**
+* @brief ARC: splits the pool between pages seen once (T1) and pages seen
+* again (T2), remembering pages replaced from each (B1, B2), and moves the
+* split towards whichever list a returning page was remembered in.
+*/
+class ARCPolicy : public BatchedPolicy
+{
+ private:
+  enum { T1 = 0, T2 = 1 };
+
+	/**
+   * Number of frames in the buffer pool
+	 */
+  std::uint32_t numBufs;
+
+	/**
+   * Target size of T1
+	 */
+  std::uint32_t p;
+
+	/**
+   * Page in each frame, for B1 and B2
+	 */
+  std::vector<PageKey> pages;
+
+  FrameLists lists;
+  GhostList b1;
+  GhostList b2;
+
+	/**
+   * Offers the frames of a list to claim, least recently used first, and
+   * remembers the page of the frame claimed in ghost
+	 */
+  bool victimFrom(const std::uint8_t list, GhostList& ghost, FrameId& frame, const Claim& claim);
+
+ protected:
+  void applyAccess(const FrameId frame);
+
+ public:
+  ARCPolicy(const std::uint32_t numBufs);
+
+  const char* name() const { return "ARC"; }
+  void admit(const FrameId frame, const File* file, const PageId pageNo);
+  void remove(const FrameId frame);
+  bool victim(FrameId& frame, const Claim& claim);
+};
+
+}
@@ -7,6 +7,7 @@
 
 #include <memory>
 #include <iostream>
+#include <thread>
 #include "buffer.h"
 #include "exceptions/buffer_exceeded_exception.h"
 #include "exceptions/page_not_pinned_exception.h"
@@ -20,7 +21,7 @@ namespace badgerdb {
 // Constructor of the class BufMgr
 //----------------------------------------
 
-BufMgr::BufMgr(std::uint32_t bufs)
+BufMgr::BufMgr(std::uint32_t bufs, const BufPolicyType policyType)
 	: numBufs(bufs) {
 	bufDescTable = new BufDesc[bufs];
 
@@ -32,10 +33,22 @@ BufMgr::BufMgr(std::uint32_t bufs)
 
   bufPool = new Page[bufs];
 
+  // every shard can map the whole pool, however unevenly pages fall
   int htsize = ((((int) (bufs * 1.2))*2)/2)+1;
-  hashTable = new BufHashTbl (htsize);  // allocate the buffer hash table
+  for (std::uint32_t i = 0; i < NUMSHARDS; i++)
+  {
+    shards[i].hashTable = new BufHashTbl (htsize);  // allocate the buffer hash table
+    shards[i].accesses = 0;
+  }
 
-  clockHand = bufs - 1;
+  policy = BufPolicy::create(policyType, bufs);
+
+  // hand out frames from the lowest one up
+  freeFrames.reserve(bufs);
+  for (FrameId i = bufs; i > 0; i--)
+  {
+    freeFrames.push_back(i - 1);
+  }
 }
 
 
@@ -46,108 +59,280 @@ BufMgr::~BufMgr() {
   	BufDesc* tmpbuf = &bufDescTable[i];
   	if (tmpbuf->valid == true && tmpbuf->dirty == true)
 		{
-			tmpbuf->file->writePage(tmpbuf->pageNo, bufPool[i]);
+			tmpbuf->file.load()->writePage(tmpbuf->pageNo, bufPool[i]);
   	}
   }
 
+  for (std::uint32_t i = 0; i < NUMSHARDS; i++)
+  {
+    delete shards[i].hashTable;
+  }
+
+  delete policy;
+
   delete [] bufDescTable;
   delete [] bufPool;
 }
 
+bool BufMgr::claimBuf(const FrameId frame, std::unique_lock<std::mutex>& guard, File*& file, PageId& pageNo, bool& contended)
+{
+  BufDesc* desc = &bufDescTable[frame];
+
+  // invalid frames are on the free list or being set up by another thread
+  if (! desc->valid)
+  {
+    contended = true;
+    return false;
+  }
+
+  // check to see if someone has it pinned
+  if (desc->pinCnt != 0)
+  {
+    return false;
+  }
+
+  // the frame may have moved on to another page meanwhile, which the mapping
+  // shows once the shard is latched
+  file = desc->file;
+  pageNo = desc->pageNo;
+  std::uint32_t shardNo = shardOf(file, pageNo);
+  BufShard& shard = shards[shardNo];
+
+  std::unique_lock<std::mutex> shardGuard(shard.latch, std::defer_lock);
+  if (!shardGuard.try_lock())
+  {
+    contended = true;
+    return false;
+  }
+
+  FrameId mapped;
+  if (!shard.hashTable->find(file, pageNo, mapped) || mapped != frame || desc->pinCnt != 0)
+  {
+    contended = true;
+    return false;
+  }
+
+  guard = std::move(shardGuard);
+  return true;
+}
+
+
+void BufMgr::evictBuf(const FrameId frame, File* file, const PageId pageNo)
+{
+  // flush any existing changes to disk if necessary, before the page
+  // leaves the table, so that nobody reads a stale copy of it
+  BufDesc* desc = &bufDescTable[frame];
+  if (desc->dirty)
+  {
+    bufStats.diskwrites++;
+    std::lock_guard<std::mutex> ioGuard(ioLatch);
+    file->writePage(pageNo, bufPool[frame]);
+  }
+
+  // remove previous entry from hash table
+  shards[shardOf(file, pageNo)].hashTable->remove(file, pageNo);
+
+  //Reset all the BufDesc entry for the frame before returning the frame
+  desc->Clear();
+  desc->pinCnt = 1;
+}
+
+
 void BufMgr::allocBuf(FrameId & frame) 
 {
-  // perform first part of clock algorithm to search for 
-  // open buffer frame
-  // Assumes non-concurrent access to buffer manager
-  std::uint32_t numScanned = 0;
-  bool found = 0;
+  // frames skipped only because another thread was busy with them; the pool
+  // is full only if the policy offers none but pinned frames
+  bool contended = true;
+
+  // latch of the shard mapping the page of the frame claimed, and that page
+  std::unique_lock<std::mutex> victimGuard;
+  File* victimFile = NULL;
+  PageId victimPageNo = Page::INVALID_NUMBER;
 
-  while (numScanned < 2*numBufs)	//Need to scn twice
+  BufPolicy::Claim claim = [&](const FrameId hand) -> bool
   {
-    // advance the clock
-    advanceClock();
-    numScanned++;
+    return claimBuf(hand, victimGuard, victimFile, victimPageNo, contended);
+  };
 
-    // if invalid, use frame
-    if (! bufDescTable[clockHand].valid)
-    {
-      break;
-    }
+  while (contended)
+  {
+    contended = false;
 
-    // is valid, check referenced bit
-    if (! bufDescTable[clockHand].refbit)
     {
-      // check to see if someone has it pinned
-      if (bufDescTable[clockHand].pinCnt == 0)
+      std::lock_guard<std::mutex> freeGuard(freeLatch);
+      if (!freeFrames.empty())
       {
-        // hasn't been referenced and is not pinned, use it
-        // remove previous entry from hash table
-        hashTable->remove(bufDescTable[clockHand].file, bufDescTable[clockHand].pageNo);
-        found = true;
-        break;
+        frame = freeFrames.back();
+        freeFrames.pop_back();
+        bufDescTable[frame].pinCnt = 1;
+        return;
       }
     }
-    else
+
+    if (policy->victim(frame, claim))
     {
-      // has been referenced, clear the bit
-      bufStats.accesses++;
-      bufDescTable[clockHand].refbit = false;
+      evictBuf(frame, victimFile, victimPageNo);
+      return;
     }
+
+    if (contended)
+      std::this_thread::yield();
   }
-  
+
   // check for full buffer pool
-  if (!found && numScanned >= 2*numBufs)
-  {
-    throw BufferExceededException();
-  }
-  
-  // flush any existing changes to disk if necessary
-  if (bufDescTable[clockHand].dirty)
-  {
-    bufStats.diskwrites++;
-    //status = bufDescTable[clockHand].file->writePage(bufDescTable[clockHand].pageNo,
-    bufDescTable[clockHand].file->writePage(bufDescTable[clockHand].pageNo, bufPool[clockHand]);
-  }
+  throw BufferExceededException();
+} // end allocBuf
 
-	//Reset all the BufDesc entry for the frame before returning the frame
-  bufDescTable[clockHand].Clear();
 
-  // return new frame number
-  frame = clockHand;
-} // end allocBuf
+bool BufMgr::reuseRingBuf(BufRing& ring, FrameId& frame)
+{
+  if (ring.size() == 0)
+    return false;
+
+  BufRing::Slot& slot = ring.slots[ring.next];
+  if (slot.file == NULL)
+    return false;
+
+  // someone else's page may have taken the frame since; leave it be
+  std::unique_lock<std::mutex> guard;
+  File* file;
+  PageId pageNo;
+  bool contended = false;
+  if (!claimBuf(slot.frame, guard, file, pageNo, contended) || file != slot.file || pageNo != slot.pageNo)
+    return false;
+
+  policy->remove(slot.frame);
+  evictBuf(slot.frame, file, pageNo);
+  frame = slot.frame;
+  return true;
+}
+
+
+void BufMgr::freeBuf(const FrameId frame)
+{
+  policy->remove(frame);
+  bufDescTable[frame].Clear();
+
+  std::lock_guard<std::mutex> freeGuard(freeLatch);
+  freeFrames.push_back(frame);
+}
 
 	
-void BufMgr::readPage(File* file, const PageId pageNo, Page*& page)
+void BufMgr::readPage(File* file, const PageId pageNo, Page*& page, BufRing* ring)
 {
   // check to see if it is already in the buffer pool
   // std::cout << "readPage called on file.page " << file << "." << pageNo << endl;
+  std::uint32_t shardNo = shardOf(file, pageNo);
+  BufShard& shard = shards[shardNo];
+  std::unique_lock<std::mutex> guard(shard.latch);
+  countAccess(shard);
+
   FrameId frameNo = 0;
-	try
-	{
-  	hashTable->lookup(file, pageNo, frameNo);
+  while (true)
+  {
+    if (shard.hashTable->find(file, pageNo, frameNo))
+    {
+      if (!bufDescTable[frameNo].reading)
+        break;
 
-    // set the referenced bit
-    bufDescTable[frameNo].refbit = true;
-    bufDescTable[frameNo].pinCnt++;
+      // another thread is reading the page in; wait for its frame, not the shard
+      guard.unlock();
+      waitForRead(frameNo, file, pageNo);
+      guard.lock();
+      continue;
+    }
+
+    // finding a frame may wait on other shards' latches, so this one is let
+    // go meanwhile; a thread holding none never waits on one holding a latch
+    guard.unlock();
+
+    // a scan with a ring takes back the frame it read into a ring ago, so
+    // only the ring's frames leave the rest of the pool
+    if (ring == NULL || !reuseRingBuf(*ring, frameNo))
+    {
+      // alloc a new frame
+      allocBuf(frameNo);
+    }
+
+    guard.lock();
+
+    // another thread may have read the page in meanwhile
+    FrameId mapped;
+    if (shard.hashTable->find(file, pageNo, mapped))
+    {
+      freeBuf(frameNo);
+      continue;
+    }
+
+    // map the page before reading it, marked as being read, so that other
+    // threads wanting it wait for it instead of reading it twice
+    BufDesc* desc = &bufDescTable[frameNo];
+    desc->Set(file, pageNo);
+    desc->reading = true;
+    shard.hashTable->insert(file, pageNo, frameNo);
+    policy->admit(frameNo, file, pageNo);
+    guard.unlock();
+
+    // files read at a position, so reads run outside every latch
+    try
+    {
+      bufStats.diskreads++;
+      //status = file->readPage(pageNo, &bufPool[frameNo]);
+      bufPool[frameNo] = file->readPage(pageNo);
+    }
+    catch(...)
+    {
+      guard.lock();
+      shard.hashTable->remove(file, pageNo);
+      endRead(frameNo);
+      freeBuf(frameNo);
+      throw;
+    }
+
+    endRead(frameNo);
     page = &bufPool[frameNo];
+
+    if (ring != NULL && ring->size() > 0)
+    {
+      BufRing::Slot& slot = ring->slots[ring->next];
+      slot.frame = frameNo;
+      slot.file = file;
+      slot.pageNo = pageNo;
+      ring->next = (ring->next + 1) % ring->size();
+    }
+    return;
   }
-  catch(HashNotFoundException e) //not in the buffer pool, must allocate a new page
-  {
-    // alloc a new frame
-    allocBuf(frameNo);
 
-    // read the page into the new frame
-    bufStats.diskreads++;
-    //status = file->readPage(pageNo, &bufPool[frameNo]);
-    bufPool[frameNo] = file->readPage(pageNo);
+  policy->access(frameNo);
+
+  // pin counts of mapped frames only change under the shard latch, so a
+  // plain load and store will do
+  BufDesc* desc = &bufDescTable[frameNo];
+  desc->pinCnt.store(desc->pinCnt.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  page = &bufPool[frameNo];
+}
+
+
+void BufMgr::waitForRead(const FrameId frame, const File* file, const PageId pageNo)
+{
+  // the frame may since have been freed or taken by another page, which
+  // also ends the wait; the caller looks the page up again either way
+  BufDesc* desc = &bufDescTable[frame];
+  std::unique_lock<std::mutex> readGuard(readLatch);
+  readDone.wait(readGuard, [&]() -> bool
+  {
+    return !desc->reading || desc->file != file || desc->pageNo != pageNo;
+  });
+}
 
-    // set up the entry properly
-    bufDescTable[frameNo].Set(file, pageNo);
-    page = &bufPool[frameNo];
 
-    // insert in the hash table
-    hashTable->insert(file, pageNo, frameNo);
+void BufMgr::endRead(const FrameId frame)
+{
+  {
+    std::lock_guard<std::mutex> readGuard(readLatch);
+    bufDescTable[frame].reading = false;
   }
+  readDone.notify_all();
 }
 
 
@@ -155,17 +340,25 @@ void BufMgr::unPinPage(File* file, const PageId pageNo,
 			     const bool dirty) 
 {
   // lookup in hashtable
+  BufShard& shard = shards[shardOf(file, pageNo)];
+  std::lock_guard<std::mutex> guard(shard.latch);
+
   FrameId frameNo = 0;
-  hashTable->lookup(file, pageNo, frameNo);
+  if (!shard.hashTable->find(file, pageNo, frameNo))
+  {
+    throw HashNotFoundException(file->filename(), pageNo);
+  }
 
-  if (dirty == true) bufDescTable[frameNo].dirty = dirty;
+  BufDesc* desc = &bufDescTable[frameNo];
+  if (dirty == true) desc->dirty.store(true, std::memory_order_relaxed);
 
   // make sure the page is actually pinned
-  if (bufDescTable[frameNo].pinCnt == 0)
+  int pinCnt = desc->pinCnt.load(std::memory_order_relaxed);
+  if (pinCnt == 0)
   {
   	throw PageNotPinnedException(file->filename(), pageNo, frameNo);
   }
-  else bufDescTable[frameNo].pinCnt--;
+  else desc->pinCnt.store(pinCnt - 1, std::memory_order_relaxed);
 }
 
 void BufMgr::flushFile(const File* file) 
@@ -175,21 +368,32 @@ void BufMgr::flushFile(const File* file)
   	BufDesc* tmpbuf = &(bufDescTable[i]);
   	if(tmpbuf->valid == true && tmpbuf->file == file)
 		{
+      PageId pageNo = tmpbuf->pageNo;
+      BufShard& shard = shards[shardOf(file, pageNo)];
+      std::lock_guard<std::mutex> guard(shard.latch);
+
+      // skip the frame if another thread replaced its page meanwhile
+      FrameId mapped;
+      if (!shard.hashTable->find(file, pageNo, mapped) || mapped != i)
+        continue;
+
 	    if (tmpbuf->pinCnt > 0)
-  			throw PagePinnedException(file->filename(), tmpbuf->pageNo, tmpbuf->frameNo);
+  			throw PagePinnedException(file->filename(), pageNo, tmpbuf->frameNo);
 
 	    if (tmpbuf->dirty == true)
 			{
 				//if ((status = tmpbuf->file->writePage(tmpbuf->pageNo, &(bufPool[i]))) != OK)
-				tmpbuf->file->writePage(tmpbuf->pageNo, bufPool[i]);
+				std::lock_guard<std::mutex> ioGuard(ioLatch);
+				tmpbuf->file.load()->writePage(pageNo, bufPool[i]);
+				bufStats.diskwrites++;
 				tmpbuf->dirty = false;
     	}
 
-    	hashTable->remove(file,tmpbuf->pageNo);
-    	tmpbuf->Clear();
+    	shard.hashTable->remove(file, pageNo);
+    	freeBuf(i);
   	}
 		else if (tmpbuf->valid == false && tmpbuf->file == file)
-  		throw BadBufferException(tmpbuf->frameNo, tmpbuf->dirty, tmpbuf->valid, tmpbuf->refbit);
+  		throw BadBufferException(tmpbuf->frameNo, tmpbuf->dirty, tmpbuf->valid, false);
   }
 }
 
@@ -197,15 +401,23 @@ void BufMgr::disposePage(File* file, const PageId pageNo)
 {
 	//Deallocate from file altogether
   //See if it is in the buffer pool
-  FrameId frameNo = 0;
-  hashTable->lookup(file, pageNo, frameNo);
+  {
+    BufShard& shard = shards[shardOf(file, pageNo)];
+    std::lock_guard<std::mutex> guard(shard.latch);
 
-	// clear the page
-	bufDescTable[frameNo].Clear();
+    //not in the buffer pool, nothing to clear
+    FrameId frameNo = 0;
+    if (shard.hashTable->find(file, pageNo, frameNo))
+    {
+      shard.hashTable->remove(file, pageNo);
 
-	hashTable->remove(file, pageNo);
+      // clear the page
+      freeBuf(frameNo);
+    }
+  }
 
   // deallocate it in the file	
+  std::lock_guard<std::mutex> ioGuard(ioLatch);
   file->deletePage(pageNo);
 }
 
@@ -219,14 +431,27 @@ void BufMgr::allocPage(File* file, PageId &pageNo, Page*& page)
 
   // allocate a new page in the file
 	//std::cerr << "buffer data size:" << bufPool[frameNo].data_.length() << "\n";
-  bufPool[frameNo] = file->allocatePage(pageNo);
+  try
+  {
+    std::lock_guard<std::mutex> ioGuard(ioLatch);
+    bufPool[frameNo] = file->allocatePage(pageNo);
+  }
+  catch(...)
+  {
+    freeBuf(frameNo);
+    throw;
+  }
   page = &bufPool[frameNo];
 
   // set up the entry properly
+  BufShard& shard = shards[shardOf(file, pageNo)];
+  std::lock_guard<std::mutex> guard(shard.latch);
+  countAccess(shard);
   bufDescTable[frameNo].Set(file, pageNo);
 
   // insert in the hash table
-  hashTable->insert(file, pageNo, frameNo);
+  shard.hashTable->insert(file, pageNo, frameNo);
+  policy->admit(frameNo, file, pageNo);
 }
 
 void BufMgr::printSelf(void) 
@@ -9,7 +9,12 @@
 
 #include "file.h"
 #include "bufHashTbl.h"
+#include "bufPolicy.h"
+#include <atomic>
+#include <condition_variable>
 #include <iostream>
+#include <mutex>
+#include <vector>
 
 namespace badgerdb {
 
@@ -20,6 +25,11 @@ class BufMgr;
 
 /**
 * @brief Class for maintaining information about buffer pool frames
+*
+* Fields are atomic since replacement reads them without latches.  They
+* change only under the latch of the shard mapping the frame's page, or while
+* the frame is mapped by no shard and owned by the one thread setting it up,
+* which also clears reading once the page is in.
 */
 class BufDesc {
 
@@ -29,12 +39,12 @@ class BufDesc {
 	/**
    * Pointer to file to which corresponding frame is assigned
 	 */
-  File* file;
+  std::atomic<File*> file;
 
 	/**
    * Page within file to which corresponding frame is assigned
 	 */
-  PageId pageNo;
+  std::atomic<PageId> pageNo;
 
 	/**
    * Frame number of the frame, in the buffer pool, being used
@@ -44,22 +54,23 @@ class BufDesc {
 	/**
    * Number of times this page has been pinned
 	 */
-  int pinCnt;
+  std::atomic<int> pinCnt;
 
 	/**
    * True if page is dirty;  false otherwise
 	 */
-  bool dirty;
+  std::atomic<bool> dirty;
 
 	/**
    * True if page is valid
 	 */
-  bool valid;
+  std::atomic<bool> valid;
 
 	/**
-   * Has this buffer frame been reference recently
+   * True while the page is read from disk into the frame, which the reading
+   * thread holds pinned
 	 */
-  bool refbit;
+  std::atomic<bool> reading;
 
 	/**
    * Initialize buffer frame for a new user
@@ -70,8 +81,8 @@ class BufDesc {
 		file = NULL;
 		pageNo = Page::INVALID_NUMBER;
     dirty = false;
-    refbit = false;
-		valid = false;
+    reading = false;
+		valid = false;  // last, so replacement skips the frame once it is cleared
   };
 
 	/**
@@ -88,14 +99,14 @@ class BufDesc {
     pinCnt = 1;
     dirty = false;
     valid = true;
-    refbit = true;
   }
 
   void Print()
 	{
-		if(file != NULL)
+		File* filePtr = file;
+		if(filePtr != NULL)
 		{
-			std::cout << "file:" << file->filename() << " ";
+			std::cout << "file:" << filePtr->filename() << " ";
 			std::cout << "pageNo:" << pageNo << " ";
 		}
 		else
@@ -103,8 +114,7 @@ class BufDesc {
 
 		std::cout << "valid:" << valid << " ";
 		std::cout << "pinCnt:" << pinCnt << " ";
-		std::cout << "dirty:" << dirty << " ";
-		std::cout << "refbit:" << refbit << "\n";
+		std::cout << "dirty:" << dirty << "\n";
   }
 
 	/**
@@ -125,17 +135,17 @@ struct BufStats
 	/**
    * Total number of accesses to buffer pool
 	 */
-  int accesses;
+  std::atomic<int> accesses;
 
 	/**
    * Number of pages read from disk (including allocs)
 	 */
-  int diskreads;
+  std::atomic<int> diskreads;
 
 	/**
    * Number of pages written back to disk
 	 */
-  int diskwrites;
+  std::atomic<int> diskwrites;
 
 	/**
    * Clear all values 
@@ -155,16 +165,112 @@ struct BufStats
 };
 
 
+/**
+* @brief Frames a sequential scan recycles, so that reading a large file takes
+* a ring of frames from the buffer pool instead of all of it.  A page missed
+* through the ring goes into the frame the ring read into size() misses ago,
+* if that frame still holds that page and nobody has it pinned.
+*
+* Belongs to one scan and is not threadsafe.
+*/
+class BufRing
+{
+	friend class BufMgr;
+
+ private:
+	/**
+   * Frame a page was read into through the ring, and the page
+	 */
+  struct Slot
+  {
+    FrameId frame;
+    File* file;
+    PageId pageNo;
+  };
+
+	/**
+   * One slot per frame of the ring; a slot with a NULL file is empty
+	 */
+  std::vector<Slot> slots;
+
+	/**
+   * Slot whose frame the next miss goes into
+	 */
+  std::uint32_t next;
+
+ public:
+	/**
+   * Ring size scans use unless told otherwise, 128KB of pages
+	 */
+  static const std::uint32_t DEFAULT_SIZE = 16;
+
+	/**
+   * Constructor of BufRing class
+	 *
+	 * @param size   	Number of frames in the ring; a ring of none reads through the whole pool
+	 */
+  BufRing(const std::uint32_t size)
+    : slots(size), next(0)
+  {
+    for (std::uint32_t i = 0; i < size; i++)
+      slots[i].file = NULL;
+  }
+
+	/**
+   * Number of frames in the ring
+	 */
+  std::uint32_t size() const
+  {
+		return slots.size();
+  }
+};
+
+
+/**
+* @brief One partition of the table mapping (File, page) to frame, with the
+* latch that guards it and the frames it maps
+*/
+struct BufShard
+{
+	/**
+   * Held while looking up, pinning, unpinning or replacing a page of the shard
+	 */
+  std::mutex latch;
+
+	/**
+   * Hash table mapping the shard's (File, page) pairs to frames
+	 */
+  BufHashTbl *hashTable;
+
+	/**
+   * Accesses to the shard's pages, only changed under the latch
+	 */
+  std::atomic<int> accesses;
+
+	/**
+   * Keeps the latches of neighbouring shards off one cache line
+	 */
+  char padding[64];
+};
+
+
 /**
 * @brief The central class which manages the buffer pool including frame allocation and deallocation to pages in the file 
+*
+* Safe to use from many threads.  Pages are spread over NUMSHARDS shards, each
+* with its own latch and hash table, so threads working on different pages
+* rarely wait for each other.  Which frame to replace is left to a BufPolicy
+* chosen at construction.  A miss reads its page with no latch held, and
+* threads wanting the page meanwhile wait for that frame alone.  Writes and
+* allocations of pages, which share file streams, go through one latch.
 */
 class BufMgr 
 {
  private:
 	/**
-   * Current position of clockhand in our buffer pool
+   * Number of shards of the page table, a power of two
 	 */
-  FrameId clockHand;
+  static const std::uint32_t NUMSHARDS = 16;
 
 	/**
    * Number of frames in the buffer pool
@@ -172,9 +278,36 @@ class BufMgr
   std::uint32_t numBufs;
 	
 	/**
-   * Hash table mapping (File, page) to frame
+   * Page table, split into shards
 	 */
-  BufHashTbl *hashTable;
+  BufShard shards[NUMSHARDS];
+
+	/**
+   * Replacement policy
+	 */
+  BufPolicy *policy;
+
+	/**
+   * Frames that hold no page, ready to be handed out without a clock sweep
+	 */
+  std::vector<FrameId> freeFrames;
+
+	/**
+   * Latch for freeFrames
+	 */
+  std::mutex freeLatch;
+
+	/**
+   * Latch for writing, allocating and deleting pages of files
+	 */
+  std::mutex ioLatch;
+
+	/**
+   * Guards clearing BufDesc::reading, so that threads waiting on readDone for
+   * a frame to be read in miss no wakeup
+	 */
+  std::mutex readLatch;
+  std::condition_variable readDone;
 
 	/**
    * Array of BufDesc objects to hold information corresponding to every frame allocation from 'bufPool' (the buffer pool)
@@ -187,7 +320,11 @@ class BufMgr
   BufStats bufStats;
 
 	/**
-	 * Allocate a free frame.  
+	 * Allocate a free frame.  The frame is returned pinned once, so no other
+	 * thread takes it before the caller sets it up.
+	 *
+	 * Called with no shard latched, so that no thread waiting for a frame
+	 * holds a latch another one waits for.
 	 *
 	 * @param frame   	Frame reference, frame ID of allocated frame returned via this variable
 	 * @throws BufferExceededException If no such buffer is found which can be allocated
@@ -195,11 +332,83 @@ class BufMgr
   void allocBuf(FrameId & frame);
 
 	/**
-   * Advance clock to next frame in the buffer pool
+	 * Takes a valid frame nobody has pinned, under the latch of the shard that
+	 * maps its page, without waiting for the latch since the caller may hold
+	 * the policy's.
+	 *
+	 * @param frame   	Frame ID
+	 * @param guard   	Takes the latch of the frame's shard
+	 * @param file   		File of the page in the frame, returned via this variable
+	 * @param pageNo  	Number of the page in the frame, returned via this variable
+	 * @param contended Set if the frame was skipped only because another thread was busy with it
+	 * @return  			True if the frame was taken
+	 */
+  bool claimBuf(const FrameId frame, std::unique_lock<std::mutex>& guard, File*& file, PageId& pageNo,
+                bool& contended);
+
+	/**
+	 * Writes back the page of a frame taken by claimBuf if it is dirty, drops the
+	 * page from the page table and hands the frame out pinned once
+	 *
+	 * @param frame   	Frame ID
+	 * @param file   		File of the page in the frame
+	 * @param pageNo  	Number of the page in the frame
 	 */
-  void advanceClock()
+  void evictBuf(const FrameId frame, File* file, const PageId pageNo);
+
+	/**
+	 * Takes back the frame of the ring's next slot, if it still holds the page
+	 * the ring read into it and nobody has that pinned
+	 *
+	 * @param ring   		Ring of the scan
+	 * @param frame   	Frame reference, the frame taken back is returned via this variable
+	 * @return  			True if the frame was taken back
+	 */
+  bool reuseRingBuf(BufRing& ring, FrameId& frame);
+
+	/**
+   * Waits, with no latch held, until the frame is no longer being read in
+   * for (file, pageNo)
+	 *
+	 * @param frame   	Frame ID
+	 * @param file   		File object
+	 * @param pageNo  	Page number in the file
+	 */
+  void waitForRead(const FrameId frame, const File* file, const PageId pageNo);
+
+	/**
+   * Marks the frame's page as read in and wakes the threads waiting for it
+	 *
+	 * @param frame   	Frame ID
+	 */
+  void endRead(const FrameId frame);
+
+	/**
+   * Clears a frame, tells the policy its page left and returns it to the free list
+	 *
+	 * @param frame   	Frame ID
+	 */
+  void freeBuf(const FrameId frame);
+
+	/**
+   * Counts an access to a page of the shard, whose latch the caller holds
+	 */
+  void countAccess(BufShard& shard)
   {
-		clockHand = (clockHand + 1) % numBufs;
+		shard.accesses.store(shard.accesses.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+	/**
+   * Returns the shard of the page table that maps (file, pageNo).  Uses other
+   * bits than BufHashTbl does, so each shard's table stays evenly filled.
+	 *
+	 * @param file   	File object
+	 * @param pageNo  Page number in the file
+	 * @return  			Shard number
+	 */
+  std::uint32_t shardOf(const File* file, const PageId pageNo) const
+  {
+		return (pageNo ^ (std::uint32_t)((uintptr_t)file >> 4)) & (NUMSHARDS - 1);
   }
 
 
@@ -211,8 +420,11 @@ class BufMgr
 
 	/**
    * Constructor of BufMgr class
+	 *
+	 * @param bufs   	Number of frames in the buffer pool
+	 * @param policyType Replacement policy
 	 */
-  BufMgr(std::uint32_t bufs);
+  BufMgr(std::uint32_t bufs, const BufPolicyType policyType = CLOCK_POLICY);
 	
 	/**
    * Destructor of BufMgr class
@@ -227,8 +439,9 @@ class BufMgr
 	 * @param file   	File object
 	 * @param PageNo  Page number in the file to be read
 	 * @param page  	Reference to page pointer. Used to fetch the Page object in which requested page from file is read in.
+	 * @param ring  	Ring of frames to read the page into if it isn't in the pool, or NULL to use any frame
 	 */
-  void readPage(File* file, const PageId PageNo, Page*& page);
+  void readPage(File* file, const PageId PageNo, Page*& page, BufRing* ring = NULL);
 
 	/**
 	 * Unpin a page from memory since it is no longer required for it to remain in memory.
@@ -280,6 +493,10 @@ class BufMgr
 	 */
   BufStats & getBufStats()
   {
+		int accesses = 0;
+		for (std::uint32_t i = 0; i < NUMSHARDS; i++)
+			accesses += shards[i].accesses;
+		bufStats.accesses = accesses;
 		return bufStats;
   }
 
@@ -288,7 +505,17 @@ class BufMgr
 	 */
   void clearBufStats() 
   {
+		for (std::uint32_t i = 0; i < NUMSHARDS; i++)
+			shards[i].accesses = 0;
 		bufStats.clear();
+  }
+
+	/**
+   * Name of the replacement policy
+	 */
+  const char* policyName() const
+  {
+		return policy->name();
   }
 };
 
@@ -7,12 +7,17 @@
 
 #include "file.h"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <memory>
 #include <string>
 #include <cstdio>
+#include <cstring>
 #include <cassert>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "exceptions/file_exists_exception.h"
 #include "exceptions/file_not_found_exception.h"
@@ -64,13 +69,15 @@ PageId File::getFirstPageNo() {
   return header.first_used_page;
 }
 
-File::File(const std::string& name, const bool create_new) : filename_(name) {
+File::File(const std::string& name, const bool create_new)
+    : filename_(name), fd_(-1) {
   openIfNeeded(create_new);
 
   if (create_new) {
     // File starts with 1 page (the header).
     FileHeader header = {1 /* num_pages */, 0 /* first_used_page */,
-                         0 /* num_free_pages */, 0 /* first_free_page */};
+                         0 /* num_free_pages */, 0 /* first_free_page */,
+                         0 /* record_size */, 0 /* num_columns */};
     writeHeader(header);
   }
 }
@@ -100,6 +107,7 @@ void File::openIfNeeded(const bool create_new) {
     open_streams_[filename_] = stream_;
     open_counts_[filename_] = 1;
   }
+  fd_ = ::open(filename_.c_str(), O_RDONLY);
 }
 
 void File::close() {
@@ -107,6 +115,10 @@ void File::close() {
   	--open_counts_[filename_];
 
   stream_.reset();
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
 	assert(open_counts_[filename_] >= 0);
 
   if (open_counts_[filename_] == 0) {
@@ -115,10 +127,26 @@ void File::close() {
   }
 }
 
+void File::readAt(const std::streampos position, char* data,
+                  const std::size_t length) const {
+  std::size_t done = 0;
+  while (done < length) {
+    const ssize_t count = ::pread(fd_, data + done, length - done,
+                                  static_cast<off_t>(position) + done);
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count <= 0) {
+      break;
+    }
+    done += count;
+  }
+  std::memset(data + done, 0, length - done);
+}
+
 FileHeader File::readHeader() const {
   FileHeader header;
-  stream_->seekg(0 /* pos */, std::ios::beg);
-  stream_->read(reinterpret_cast<char*>(&header), sizeof(FileHeader));
+  readAt(0 /* pos */, reinterpret_cast<char*>(&header), sizeof(FileHeader));
   return header;
 }
 
@@ -136,6 +164,28 @@ PageFile PageFile::create(const std::string& filename) {
   return PageFile(filename, true /* create_new */);
 }
 
+PageFile PageFile::create(const std::string& filename,
+                          const std::uint16_t record_size) {
+  PageFile new_file(filename, true /* create_new */);
+  FileHeader header = new_file.readHeader();
+  header.record_size = record_size;
+  new_file.writeHeader(header);
+  return new_file;
+}
+
+PageFile PageFile::create(const std::string& filename,
+                          const std::uint16_t record_size,
+                          const std::vector<PageColumn>& columns) {
+  assert(!columns.empty() && columns.size() <= FileHeader::MAX_COLUMNS);
+  PageFile new_file(filename, true /* create_new */);
+  FileHeader header = new_file.readHeader();
+  header.record_size = record_size;
+  header.num_columns = columns.size();
+  std::copy(columns.begin(), columns.end(), header.columns);
+  new_file.writeHeader(header);
+  return new_file;
+}
+
 PageFile PageFile::open(const std::string& filename) {
   return PageFile(filename, false /* create_new */);
 }
@@ -224,6 +274,12 @@ Page PageFile::allocatePage(PageId &new_page_number) {
     }
     ++header.num_pages;
   }
+  if (header.num_columns != 0) {
+    new_page.initializePax(header.record_size, header.columns,
+                           header.num_columns);
+  } else if (header.record_size != 0) {
+    new_page.initializeFixed(header.record_size);
+  }
   writePage(new_page_number, new_page.header_, new_page);
   if (existing_page.page_number() != Page::INVALID_NUMBER) {
     // If we updated an existing page by inserting the new page into the
@@ -247,9 +303,10 @@ Page PageFile::readPage(const PageId page_number) const {
 
 Page PageFile::readPage(const PageId page_number, const bool allow_free) const {
   Page page;
-  stream_->seekg(pagePosition(page_number), std::ios::beg);
-  stream_->read(reinterpret_cast<char*>(&page.header_), sizeof(PageHeader));
-  stream_->read(reinterpret_cast<char*>(&page.data_[0]), Page::DATA_SIZE);
+  readAt(pagePosition(page_number), reinterpret_cast<char*>(&page.header_),
+         sizeof(PageHeader));
+  readAt(pagePosition(page_number) + std::streamoff(sizeof(PageHeader)),
+         reinterpret_cast<char*>(&page.data_[0]), Page::DATA_SIZE);
   if (!allow_free && !page.isUsed()) {
     throw InvalidPageException(page_number, filename_);
   }
@@ -324,8 +381,8 @@ void PageFile::writePage(const PageId page_number, const PageHeader& header,
 
 PageHeader PageFile::readPageHeader(PageId page_number) const {
   PageHeader header;
-  stream_->seekg(pagePosition(page_number), std::ios::beg);
-  stream_->read(reinterpret_cast<char*>(&header), sizeof(PageHeader));
+  readAt(pagePosition(page_number), reinterpret_cast<char*>(&header),
+         sizeof(PageHeader));
   return header;
 }
 
@@ -365,13 +422,25 @@ Page BlobFile::allocatePage(PageId &new_page_number) {
   FileHeader header = readHeader();
 	Page new_page;
 
-	new_page_number = header.num_pages;
+	if (header.num_free_pages > 0) {
+		// Reuse the most recently deleted page.
+		new_page_number = header.first_free_page;
+		header.first_free_page = readNextFreePage(new_page_number);
+		--header.num_free_pages;
 
-	if (header.first_used_page == Page::INVALID_NUMBER) {
-		header.first_used_page = header.num_pages;
+		assert((header.num_free_pages == 0) ==
+		       (header.first_free_page == Page::INVALID_NUMBER));
 	}
+	else
+	{
+		new_page_number = header.num_pages;
 
-	++header.num_pages;
+		if (header.first_used_page == Page::INVALID_NUMBER) {
+			header.first_used_page = header.num_pages;
+		}
+
+		++header.num_pages;
+	}
 
 	writePage(new_page_number, new_page);
 	writeHeader(header);
@@ -381,8 +450,7 @@ Page BlobFile::allocatePage(PageId &new_page_number) {
 
 Page BlobFile::readPage(const PageId page_number) const {
 	Page page;
-	stream_->seekg(pagePosition(page_number), std::ios::beg);
-	stream_->read(reinterpret_cast<char*>(&page), Page::SIZE);
+	readAt(pagePosition(page_number), reinterpret_cast<char*>(&page), Page::SIZE);
 	return page;
 }
 
@@ -392,9 +460,30 @@ void BlobFile::writePage(const PageId new_page_number, const Page& new_page) {
 	stream_->flush();
 }
 
-//delePage should not be called for a blob_file, not supported
 void BlobFile::deletePage(const PageId page_number) {
-	throw InvalidPageException(page_number, filename_);
+	FileHeader header = readHeader();
+
+	if (page_number == Page::INVALID_NUMBER || page_number >= header.num_pages) {
+		throw InvalidPageException(page_number, filename_);
+	}
+
+	// Blob pages have no header, so a free page keeps the number of the next
+	// free page in its first bytes.
+	stream_->seekp(pagePosition(page_number), std::ios::beg);
+	stream_->write(reinterpret_cast<const char*>(&header.first_free_page), sizeof(PageId));
+	stream_->flush();
+
+	header.first_free_page = page_number;
+	++header.num_free_pages;
+
+	writeHeader(header);
+}
+
+PageId BlobFile::readNextFreePage(const PageId page_number) const {
+	PageId next_free_page;
+	readAt(pagePosition(page_number), reinterpret_cast<char*>(&next_free_page),
+	       sizeof(PageId));
+	return next_free_page;
 }
 
 }
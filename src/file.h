@@ -11,6 +11,7 @@
 #include <string>
 #include <map>
 #include <memory>
+#include <vector>
 
 #include "page.h"
 
@@ -22,6 +23,11 @@ class FileIterator;
  * @brief Header metadata for files on disk which contain pages.
  */
 struct FileHeader {
+  /**
+   * Most columns a PAX file can split its records into.
+   */
+  static const std::uint16_t MAX_COLUMNS = 16;
+
   /**
    * Number of pages allocated in the file.
    */
@@ -42,6 +48,22 @@ struct FileHeader {
    */
   PageId first_free_page;
 
+  /**
+   * Length of every record if the file holds fixed-length pages, or 0 if it
+   * holds slotted pages.
+   */
+  std::uint16_t record_size;
+
+  /**
+   * Number of columns if the file holds PAX pages, or 0 otherwise.
+   */
+  std::uint16_t num_columns;
+
+  /**
+   * Columns of the records on PAX pages.
+   */
+  PageColumn columns[MAX_COLUMNS];
+
   /**
    * Returns true if this file header is equal to the other.
    *
@@ -52,7 +74,9 @@ struct FileHeader {
     return num_pages == rhs.num_pages &&
         num_free_pages == rhs.num_free_pages &&
         first_used_page == rhs.first_used_page &&
-        first_free_page == rhs.first_free_page;
+        first_free_page == rhs.first_free_page &&
+        record_size == rhs.record_size &&
+        num_columns == rhs.num_columns;
   }
 };
 
@@ -196,6 +220,18 @@ class File {
    */
   void close();
 
+  /**
+   * Reads bytes at the given position of the file through <fd_>, without
+   * touching the shared stream, so reads may run on many threads at once.
+   * Bytes past the end of the file read as zeros.
+   *
+   * @param position  Offset from the beginning of the file.
+   * @param data      Buffer to read into.
+   * @param length    Number of bytes to read.
+   */
+  void readAt(const std::streampos position, char* data,
+              const std::size_t length) const;
+
   /**
    * Reads the header for this file from disk.
    *
@@ -233,6 +269,12 @@ class File {
    */
   std::shared_ptr<std::fstream> stream_;
 
+  /**
+   * Descriptor this object reads the file through with pread.  Writes still
+   * go through <stream_>, which flushes after each one.
+   */
+  int fd_;
+
   friend class FileIterator;
 };
 
@@ -247,6 +289,31 @@ class PageFile : public File {
    */
   static PageFile create(const std::string& filename);
 
+  /**
+   * Creates a new file whose pages are fixed-length pages holding records of
+   * exactly the given length, which saves the slot array and per-record slot
+   * of a slotted page.
+   *
+   * @param filename    Name of the file.
+   * @param record_size Length of every record in bytes.
+   * @throws  FileExistsException     If the requested file already exists.
+   */
+  static PageFile create(const std::string& filename,
+                         const std::uint16_t record_size);
+
+  /**
+   * Creates a new file whose pages are PAX pages holding records of exactly
+   * the given length, each column in a minipage of its own.
+   *
+   * @param filename    Name of the file.
+   * @param record_size Length of every record in bytes.
+   * @param columns     Columns to store, at most FileHeader::MAX_COLUMNS.
+   * @throws  FileExistsException     If the requested file already exists.
+   */
+  static PageFile create(const std::string& filename,
+                         const std::uint16_t record_size,
+                         const std::vector<PageColumn>& columns);
+
   /**
    * Opens the file named fileName and returns the corresponding File object.
 	 * It first checks if the file is already open. If so, then the new File object created uses the same input-output stream to read to or write fom
@@ -442,7 +509,8 @@ class BlobFile : public File {
   ~BlobFile();
 
   /**
-   * Allocates a new page in the file.
+   * Allocates a new page in the file, reusing the most recently deleted page
+   * if there is one.
    *
    * @return The new page.
    */
@@ -468,11 +536,21 @@ class BlobFile : public File {
   void writePage(const PageId page_number, const Page& new_page);
 
   /**
-   * Deletes a page from the file.
+   * Deletes a page from the file. The page goes on the free list and is
+   * handed out again by a later allocatePage.
    *
    * @param page_number   Number of page to delete.
+   * @throws  InvalidPageException  If the page doesn't exist in the file.
    */
   void deletePage(const PageId page_number);
+
+ private:
+  /**
+   * Returns the number of the free page following the given free page.
+   *
+   * @param page_number   Number of a free page.
+   */
+  PageId readNextFreePage(const PageId page_number) const;
 };
 
 }
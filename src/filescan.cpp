@@ -10,7 +10,8 @@
 
 namespace badgerdb { 
 
-FileScan::FileScan(const std::string &name, BufMgr *bufferMgr)
+FileScan::FileScan(const std::string &name, BufMgr *bufferMgr, const std::uint32_t ringSize)
+  : ring(ringSize)
 {
   file = new PageFile(name, false);	//dont create new file
 	bufMgr = bufferMgr;
@@ -35,8 +36,6 @@ FileScan::~FileScan()
 
 void FileScan::scanNext(RecordId& outRid)
 {
-  std::string rec;
-
   if (filePageIter == file->end())
 	{
 		throw EndOfFileException();
@@ -53,7 +52,7 @@ void FileScan::scanNext(RecordId& outRid)
 		}
 	 
 		// read the first page of the file
-    bufMgr->readPage(file, (*filePageIter).page_number(), curPage); 
+    bufMgr->readPage(file, (*filePageIter).page_number(), curPage, &ring); 
 		curDirtyFlag = false;
 
 		// get the first record off the page
@@ -61,9 +60,6 @@ void FileScan::scanNext(RecordId& outRid)
 
 		if(pageRecordIter != curPage->end()) 
 		{
-		  // get pointer to record
-		  rec = *pageRecordIter;
-
 			outRid = pageRecordIter.getCurrentRecord();
 			return;
 		}
@@ -88,16 +84,14 @@ void FileScan::scanNext(RecordId& outRid)
     }
 
     // read the next page of the file
-    bufMgr->readPage(file, (*filePageIter).page_number(), curPage);
+    bufMgr->readPage(file, (*filePageIter).page_number(), curPage, &ring);
 
     // get the first record off the page
     pageRecordIter = curPage->begin(); 
   }
 
-  // curRec points at a valid record
-  // see if the record satisfies the scan's predicate 
-  // get a pointer to the record
-  rec = *pageRecordIter;
+  // pageRecordIter points at a valid record, which stays on the page
+  // until getRecord or getRecordBytes is called for it
 
 	// return rid of the record
 	outRid = pageRecordIter.getCurrentRecord();
@@ -111,6 +105,38 @@ std::string FileScan::getRecord()
   return *pageRecordIter;
 }
 
+// returns the current record where it sits on the pinned page
+const char* FileScan::getRecordBytes(std::size_t& length)
+{
+  if (curPage->num_columns() != 0)
+  {
+    curRecord = *pageRecordIter;
+    length = curRecord.size();
+    return curRecord.data();
+  }
+  return curPage->getRecordBytes(pageRecordIter.getCurrentRecord(), length);
+}
+
+// returns a column of the next page, leaving the page pinned until the next call
+void FileScan::scanNextColumn(const std::uint16_t column, ColumnVector& outColumn)
+{
+  if (curPage != NULL)
+  {
+    bufMgr->unPinPage(file, curPage->page_number(), curDirtyFlag);
+    curPage = NULL;
+    curDirtyFlag = false;
+    filePageIter++;
+  }
+
+  if (filePageIter == file->end())
+  {
+    throw EndOfFileException();
+  }
+
+  bufMgr->readPage(file, (*filePageIter).page_number(), curPage, &ring);
+  outColumn = curPage->getColumn(column);
+}
+
 // mark current page of scan dirty
 void FileScan::markDirty()
 {
@@ -24,15 +24,23 @@ class FileScan
 {
  public:
 
-  FileScan(const std::string &name, BufMgr *bufMgr);
+  //ringSize frames, if not zero, are all the scan takes from the buffer pool
+  //for pages not already in it, so that a large scan doesn't push other pages out
+  FileScan(const std::string &name, BufMgr *bufMgr, const std::uint32_t ringSize = 0);
 
   ~FileScan();
 
   //return RecordId of next record that satisfies the scan 
   void scanNext(RecordId& outRid);
 
-  //read current record, returning pointer and length
+  //read current record, returning a copy of it
   std::string getRecord();
+  //read current record in place, returning pointer and length; valid until the next scanNext
+  const char* getRecordBytes(std::size_t& length);
+
+  //column mode for PAX relations: moves to the next page and returns the given
+  //column of it, valid until the next call; not to be mixed with scanNext
+  void scanNextColumn(const std::uint16_t column, ColumnVector& outColumn);
 
   //marks current page of scan dirty
   void markDirty();
@@ -53,9 +61,20 @@ class FileScan
    */
   Page*         curPage;
 
+  /**
+   * Frames the scan recycles; empty if it reads through the whole pool
+   */
+  BufRing       ring;
+
   FileIterator  filePageIter;
   PageIterator  pageRecordIter;
 
+  /**
+   * Current record of a PAX page, assembled by getRecordBytes since the page
+   * has no contiguous copy of it
+   */
+  std::string   curRecord;
+
   /**
    * True if page has been updated
    */
@@ -0,0 +1,194 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "key_search.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define KEY_SEARCH_X86
+#include <immintrin.h>
+#endif
+
+namespace badgerdb
+{
+
+/**
+ * Number of keys left to the vector compare once the binary search has narrowed down the slot.
+ */
+static const int SSE42WINDOW = 16;
+static const int AVX2WINDOW = 32;
+
+//---------------------------------------------------------------------------
+// scalar kernel
+//---------------------------------------------------------------------------
+int findKeyIndexIntScalar(const int *keyArray, const int numKeys, const int key, const bool upper)
+{
+    return findKeyIndexScalar(keyArray, numKeys, key, upper);
+}
+
+//---------------------------------------------------------------------------
+// narrow down to a window
+//---------------------------------------------------------------------------
+//same steps as findKeyIndexScalar, stopping once at most window keys are
+//left; the slot is then base plus the number of window keys before it
+static inline const int *narrowKeyWindow(const int *keyArray, const int numKeys, const int key, const bool upper, const int window, int &length)
+{
+    const int *base = keyArray;
+    length = numKeys;
+
+    while(length > window)
+    {
+        int half = length / 2;
+        bool right = upper ? !(key < base[half - 1]) : (base[half - 1] < key);
+        base = right ? base + half : base;
+        length -= half;
+    }
+
+    return base;
+}
+
+#ifdef KEY_SEARCH_X86
+
+//---------------------------------------------------------------------------
+// SSE4.2 kernel
+//---------------------------------------------------------------------------
+__attribute__((target("sse4.2,popcnt")))
+int findKeyIndexIntSSE42(const int *keyArray, const int numKeys, const int key, const bool upper)
+{
+    int length;
+    const int *base = narrowKeyWindow(keyArray, numKeys, key, upper, SSE42WINDOW, length);
+
+    const __m128i keyVec = _mm_set1_epi32(key);
+    int count = 0;
+    int i = 0;
+
+    //lanes before the slot are the keys < key (or <= key for upper)
+    for(; i + 4 <= length; i += 4)
+    {
+        __m128i keys = _mm_loadu_si128((const __m128i*)(base + i));
+        __m128i before = upper ? _mm_andnot_si128(_mm_cmpgt_epi32(keys, keyVec), _mm_set1_epi32(-1))
+                               : _mm_cmpgt_epi32(keyVec, keys);
+
+        count += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(before)));
+    }
+
+    for(; i < length; i++)
+    {
+        count += upper ? !(key < base[i]) : (base[i] < key);
+    }
+
+    return (base - keyArray) + count;
+}
+
+//---------------------------------------------------------------------------
+// AVX2 kernel
+//---------------------------------------------------------------------------
+__attribute__((target("avx2,popcnt")))
+int findKeyIndexIntAVX2(const int *keyArray, const int numKeys, const int key, const bool upper)
+{
+    int length;
+    const int *base = narrowKeyWindow(keyArray, numKeys, key, upper, AVX2WINDOW, length);
+
+    const __m256i keyVec = _mm256_set1_epi32(key);
+    int count = 0;
+    int i = 0;
+
+    for(; i + 8 <= length; i += 8)
+    {
+        __m256i keys = _mm256_loadu_si256((const __m256i*)(base + i));
+        __m256i before = upper ? _mm256_andnot_si256(_mm256_cmpgt_epi32(keys, keyVec), _mm256_set1_epi32(-1))
+                               : _mm256_cmpgt_epi32(keyVec, keys);
+
+        count += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(before)));
+    }
+
+    for(; i < length; i++)
+    {
+        count += upper ? !(key < base[i]) : (base[i] < key);
+    }
+
+    return (base - keyArray) + count;
+}
+
+bool keySearchSupported(IntKeySearch kernel)
+{
+    __builtin_cpu_init();
+
+    if(kernel == findKeyIndexIntAVX2)
+    {
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+    }
+
+    if(kernel == findKeyIndexIntSSE42)
+    {
+        return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt");
+    }
+
+    return kernel == findKeyIndexIntScalar;
+}
+
+#else
+
+//no vector kernels on this platform, keep the symbols for callers
+int findKeyIndexIntSSE42(const int *keyArray, const int numKeys, const int key, const bool upper)
+{
+    return findKeyIndexIntScalar(keyArray, numKeys, key, upper);
+}
+
+int findKeyIndexIntAVX2(const int *keyArray, const int numKeys, const int key, const bool upper)
+{
+    return findKeyIndexIntScalar(keyArray, numKeys, key, upper);
+}
+
+bool keySearchSupported(IntKeySearch kernel)
+{
+    return kernel == findKeyIndexIntScalar;
+}
+
+#endif
+
+const char* keySearchName(IntKeySearch kernel)
+{
+    if(kernel == findKeyIndexIntAVX2)
+    {
+        return "avx2";
+    }
+
+    if(kernel == findKeyIndexIntSSE42)
+    {
+        return "sse4.2";
+    }
+
+    return "scalar";
+}
+
+//---------------------------------------------------------------------------
+// kernel selection
+//---------------------------------------------------------------------------
+//intKeySearch starts out pointing here, constant initialized so it is usable
+//during static initialization; the first search picks the kernel and
+//replaces itself
+static int resolveIntKeySearch(const int *keyArray, const int numKeys, const int key, const bool upper)
+{
+    IntKeySearch kernel = findKeyIndexIntScalar;
+
+    if(keySearchSupported(findKeyIndexIntAVX2))
+    {
+        kernel = findKeyIndexIntAVX2;
+    }
+
+    else if(keySearchSupported(findKeyIndexIntSSE42))
+    {
+        kernel = findKeyIndexIntSSE42;
+    }
+
+    intKeySearch.store(kernel, std::memory_order_relaxed);
+    return kernel(keyArray, numKeys, key, upper);
+}
+
+std::atomic<IntKeySearch> intKeySearch(resolveIntKeySearch);
+
+}
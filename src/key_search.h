@@ -0,0 +1,99 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <atomic>
+
+namespace badgerdb
+{
+
+/**
+ * @brief Finds the slot of key among the numKeys sorted keys of a node: the first key not less than key
+ * (lower bound) or, if upper is set, the first key greater than key (upper bound). For a non-leaf node the
+ * result is also the index of the child to descend into.
+ * The search is branch-free: the loop runs a fixed log2(numKeys) times and each step is a conditional move,
+ * so the mispredictions of a classic binary search over ~1000 keys go away.
+*/
+template <class T>
+inline int findKeyIndexScalar(const T *keyArray, const int numKeys, const T &key, const bool upper)
+{
+	if( numKeys == 0 )
+		return 0;
+
+	const T *base = keyArray;
+	int length = numKeys;
+
+	while( length > 1 )
+	{
+		int half = length / 2;
+		bool right = upper ? !( key < base[ half - 1 ] ) : ( base[ half - 1 ] < key );
+		base = right ? base + half : base;
+		length -= half;
+	}
+
+	bool past = upper ? !( key < *base ) : ( *base < key );
+	return ( base - keyArray ) + past;
+}
+
+/**
+ * @brief Signature of an INTEGER key search kernel. Same contract as findKeyIndexScalar.
+ */
+typedef int (*IntKeySearch)( const int *keyArray, const int numKeys, const int key, const bool upper );
+
+/**
+ * @brief Portable INTEGER kernel, findKeyIndexScalar instantiated for int.
+ */
+int findKeyIndexIntScalar( const int *keyArray, const int numKeys, const int key, const bool upper );
+
+/**
+ * @brief SSE4.2 kernel. Binary searches down to a small window, then counts the keys before
+ * the slot four at a time. Only call if keySearchSupported( findKeyIndexIntSSE42 ).
+ */
+int findKeyIndexIntSSE42( const int *keyArray, const int numKeys, const int key, const bool upper );
+
+/**
+ * @brief AVX2 kernel. Like findKeyIndexIntSSE42, eight keys at a time.
+ * Only call if keySearchSupported( findKeyIndexIntAVX2 ).
+ */
+int findKeyIndexIntAVX2( const int *keyArray, const int numKeys, const int key, const bool upper );
+
+/**
+ * @brief Returns true if the CPU this process runs on can execute the given kernel.
+ */
+bool keySearchSupported( IntKeySearch kernel );
+
+/**
+ * @brief Returns the name of the given kernel, for reporting.
+ */
+const char* keySearchName( IntKeySearch kernel );
+
+/**
+ * @brief Kernel used for every INTEGER key search. Picked through CPUID on first use:
+ * AVX2 if available, else SSE4.2, else the scalar search. Atomic since threads searching
+ * at once may all pick it; they store the same kernel, so relaxed order will do.
+ */
+extern std::atomic<IntKeySearch> intKeySearch;
+
+/**
+ * @brief Overload for INTEGER keys; dispatches to the kernel picked for this CPU.
+ */
+inline int findKeyIndex(const int *keyArray, const int numKeys, const int &key, const bool upper)
+{
+	return intKeySearch.load( std::memory_order_relaxed )( keyArray, numKeys, key, upper );
+}
+
+/**
+ * @brief Searches the keys of a node for key. See findKeyIndexScalar.
+ */
+template <class T>
+inline int findKeyIndex(const T *keyArray, const int numKeys, const T &key, const bool upper)
+{
+	return findKeyIndexScalar( keyArray, numKeys, key, upper );
+}
+
+}
@@ -5,6 +5,7 @@
  * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
  */
 
+#include <fstream>
 #include <vector>
 #include "btree.h"
 #include "page.h"
@@ -66,14 +67,32 @@ BufMgr * bufMgr = new BufMgr(100);
 
 void createRelationForward();
 void createRelationBackward();
+void createRelationPax(const std::string &paxRelationName);
 void createRelationRandom();
 void intTests();
+void runTests();
+void postingTests();
+void packedPostingTests();
+void tailTests();
+int indexPages(const std::string &indexName);
 int intScan(BTreeIndex *index, int lowVal, Operator lowOp, int highVal, Operator highOp);
+int intLookup(BTreeIndex *index, int key);
+int intLookupBatch(BTreeIndex *index, int firstKey, int numKeys);
+void doubleTests();
+int doubleScan(BTreeIndex *index, double lowVal, Operator lowOp, double highVal, Operator highOp);
+void stringTests();
+int stringScan(BTreeIndex *index, int lowVal, Operator lowOp, int highVal, Operator highOp);
+int indexScan(BTreeIndex *index, const void *lowVal, Operator lowOp, const void *highVal, Operator highOp);
+void deleteTests();
+int doubleColumnScan();
+int ringScan();
 void indexTests();
 void test1();
 void test2();
 void test3();
 void errorTests();
+void fixedPageTests();
+int pageRecordCount(Page &page);
 void deleteRelation();
 
 int main(int argc, char **argv)
@@ -103,9 +122,8 @@ int main(int argc, char **argv)
     	sprintf(record1.s, "%05d string record", i);
     	record1.i = i;
     	record1.d = (double)i;
-    	std::string new_data(reinterpret_cast<char*>(&record1), sizeof(record1));
 
-			new_page.insertRecord(new_data);
+			new_page.insertRecord(reinterpret_cast<char*>(&record1), sizeof(record1));
 			new_file.writePage(new_page_number, new_page);
 		}
 
@@ -140,6 +158,7 @@ int main(int argc, char **argv)
 	test1();
 	test2();
 	test3();
+	fixedPageTests();
 	errorTests();
 
   return 1;
@@ -152,6 +171,7 @@ void test1()
 	std::cout << "---------------------" << std::endl;
 	std::cout << "createRelationForward" << std::endl;
 	createRelationForward();
+	checkPassFail(ringScan(), relationSize)
 	indexTests();
 	deleteRelation();
 }
@@ -163,6 +183,7 @@ void test2()
 	std::cout << "----------------------" << std::endl;
 	std::cout << "createRelationBackward" << std::endl;
 	createRelationBackward();
+	checkPassFail(doubleColumnScan(), relationSize)
 	indexTests();
 	deleteRelation();
 }
@@ -194,7 +215,7 @@ void createRelationForward()
 	{
 	}
 
-  file1 = new PageFile(relationName, true);
+  file1 = new PageFile(PageFile::create(relationName));
 
   // initialize all of record1.s to keep purify happy
   memset(record1.s, ' ', sizeof(record1.s));
@@ -207,13 +228,12 @@ void createRelationForward()
     sprintf(record1.s, "%05d string record", i);
     record1.i = i;
     record1.d = (double)i;
-    std::string new_data(reinterpret_cast<char*>(&record1), sizeof(record1));
 
 		while(1)
 		{
 			try
 			{
-    		new_page.insertRecord(new_data);
+    		new_page.insertRecord(reinterpret_cast<char*>(&record1), sizeof(record1));
 				break;
 			}
 			catch(InsufficientSpaceException e)
@@ -241,7 +261,8 @@ void createRelationBackward()
 	catch(FileNotFoundException e)
 	{
 	}
-  file1 = new PageFile(relationName, true);
+
+  file1 = new PageFile(PageFile::create(relationName));
 
   // initialize all of record1.s to keep purify happy
   memset(record1.s, ' ', sizeof(record1.s));
@@ -255,13 +276,12 @@ void createRelationBackward()
     record1.i = i;
     record1.d = i;
 
-    std::string new_data(reinterpret_cast<char*>(&record1), sizeof(RECORD));
 
 		while(1)
 		{
 			try
 			{
-    		new_page.insertRecord(new_data);
+    		new_page.insertRecord(reinterpret_cast<char*>(&record1), sizeof(record1));
 				break;
 			}
 			catch(InsufficientSpaceException e)
@@ -275,6 +295,146 @@ void createRelationBackward()
 	file1->writePage(new_page_number, new_page);
 }
 
+// -----------------------------------------------------------------------------
+// createRelationPax
+// -----------------------------------------------------------------------------
+
+//creates a relation of PAX pages holding the same tuples as the backward one,
+//every attribute in a minipage of its own
+void createRelationPax(const std::string &paxRelationName)
+{
+	try
+	{
+		File::remove(paxRelationName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+
+  std::vector<PageColumn> columns;
+  PageColumn column;
+  column.offset = offsetof(RECORD, i);
+  column.size = sizeof(record1.i);
+  columns.push_back(column);
+  column.offset = offsetof(RECORD, d);
+  column.size = sizeof(record1.d);
+  columns.push_back(column);
+  column.offset = offsetof(RECORD, s);
+  column.size = sizeof(record1.s);
+  columns.push_back(column);
+  PageFile paxFile = PageFile::create(paxRelationName, sizeof(RECORD), columns);
+
+  RECORD record;
+  memset(record.s, ' ', sizeof(record.s));
+	PageId new_page_number;
+  Page new_page = paxFile.allocatePage(new_page_number);
+
+  for(int i = relationSize - 1; i >= 0; i-- )
+	{
+    sprintf(record.s, "%05d string record", i);
+    record.i = i;
+    record.d = i;
+
+		while(1)
+		{
+			try
+			{
+    		new_page.insertRecord(reinterpret_cast<char*>(&record), sizeof(record));
+				break;
+			}
+			catch(InsufficientSpaceException e)
+			{
+				paxFile.writePage(new_page_number, new_page);
+  			new_page = paxFile.allocatePage(new_page_number);
+			}
+		}
+  }
+
+	paxFile.writePage(new_page_number, new_page);
+}
+
+// -----------------------------------------------------------------------------
+// doubleColumnScan
+// -----------------------------------------------------------------------------
+
+//sums the d column of a PAX relation a page at a time, returning the number
+//of records read, or -1 if the sum is off
+int doubleColumnScan()
+{
+	const std::string paxRelationName = "relPax";
+	createRelationPax(paxRelationName);
+
+	int numRecords = 0;
+	double sum = 0;
+	{
+		FileScan fscan(paxRelationName, bufMgr);
+
+		try
+		{
+			ColumnVector column;
+
+			while(1)
+			{
+				fscan.scanNextColumn(1, column);
+
+				for(SlotId slot = 1; slot <= column.num_slots; slot++)
+				{
+					if((column.used[(slot - 1) / 32] >> ((slot - 1) % 32)) & 1)
+					{
+						sum += *reinterpret_cast<const double*>(column.values + (slot - 1) * column.value_size);
+						numRecords++;
+					}
+				}
+			}
+		}
+		catch(EndOfFileException e)
+		{
+		}
+	}
+
+	File::remove(paxRelationName);
+
+	if(sum != (double)relationSize * (relationSize - 1) / 2)
+	{
+		return -1;
+	}
+	return numRecords;
+}
+
+// -----------------------------------------------------------------------------
+// ringScan
+// -----------------------------------------------------------------------------
+
+//reads the forward relation through a ring of two frames, returning the number
+//of records read, or -1 if one is out of order
+int ringScan()
+{
+	int numRecords = 0;
+	FileScan fscan(relationName, bufMgr, 2);
+
+	try
+	{
+		while(1)
+		{
+			RecordId scanRid;
+			fscan.scanNext(scanRid);
+
+			std::size_t recordLength;
+			const RECORD* record = reinterpret_cast<const RECORD*>(fscan.getRecordBytes(recordLength));
+			if(record->i != numRecords)
+			{
+				return -1;
+			}
+			numRecords++;
+		}
+	}
+	catch(EndOfFileException e)
+	{
+	}
+
+	return numRecords;
+}
+
 // -----------------------------------------------------------------------------
 // createRelationRandom
 // -----------------------------------------------------------------------------
@@ -315,13 +475,12 @@ void createRelationRandom()
     record1.i = val;
     record1.d = val;
 
-    std::string new_data(reinterpret_cast<char*>(&record1), sizeof(RECORD));
 
 		while(1)
 		{
 			try
 			{
-    		new_page.insertRecord(new_data);
+    		new_page.insertRecord(reinterpret_cast<char*>(&record1), sizeof(record1));
 				break;
 			}
 			catch(InsufficientSpaceException e)
@@ -349,6 +508,25 @@ void indexTests()
   if(testNum == 1)
   {
     intTests();
+    deleteTests();
+		try
+		{
+			File::remove(intIndexName);
+		}
+  	catch(FileNotFoundException e)
+  	{
+  	}
+
+    runTests();
+		try
+		{
+			File::remove(intIndexName);
+		}
+  	catch(FileNotFoundException e)
+  	{
+  	}
+
+    postingTests();
 		try
 		{
 			File::remove(intIndexName);
@@ -356,6 +534,28 @@ void indexTests()
   	catch(FileNotFoundException e)
   	{
   	}
+
+    packedPostingTests();
+
+    tailTests();
+
+    doubleTests();
+		try
+		{
+			File::remove(doubleIndexName);
+		}
+  	catch(FileNotFoundException e)
+  	{
+  	}
+
+    stringTests();
+		try
+		{
+			File::remove(stringIndexName);
+		}
+  	catch(FileNotFoundException e)
+  	{
+  	}
   }
 }
 
@@ -376,24 +576,476 @@ void intTests()
 	checkPassFail(intScan(&index,0,GT,1,LT), 0)
 	checkPassFail(intScan(&index,300,GT,400,LT), 99)
 	checkPassFail(intScan(&index,3000,GTE,4000,LT), 1000)
+	checkPassFail(intLookup(&index,4999), 1)
+	checkPassFail(intLookup(&index,5000), 0)
+	int key = 0;
+	checkPassFail(index.exists(&key), true)
+	checkPassFail(intLookupBatch(&index,4900,200), 100)
+}
+
+// -----------------------------------------------------------------------------
+// runTests
+// -----------------------------------------------------------------------------
+
+void runTests()
+{
+  std::cout << "Bulk load the integer index from sorted runs spilled to disk" << std::endl;
+  // runs of a fifth of the relation, so that the last one is spilled full,
+  // read through the whole pool instead of a ring
+  BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER, BULKLOAD_FILLFACTOR, relationSize / 5, PLAIN_LEAF, 0);
+
+	checkPassFail(intScan(&index,0,GTE,5000,LT), 5000)
+	checkPassFail(intScan(&index,995,GT,3005,LT), 2009)
+	checkPassFail(intLookup(&index,4999), 1)
+}
+
+// -----------------------------------------------------------------------------
+// postingTests
+// -----------------------------------------------------------------------------
+
+void postingTests()
+{
+  std::cout << "Create a B+ Tree index on the integer field with posting list leaves" << std::endl;
+  BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER, BULKLOAD_FILLFACTOR, BULKLOAD_RUNSIZE, POSTING_LEAF);
+
+	checkPassFail(intScan(&index,25,GT,40,LT), 14)
+	checkPassFail(intScan(&index,3000,GTE,4000,LT), 1000)
+	checkPassFail(intLookup(&index,4999), 1)
+
+	// enough duplicates of one key to need several posting lists, pointing
+	// at records of the relation so scans can read them
+	int key = 42;
+	std::vector<RecordId> rids;
+	{
+		FileScan fscan(relationName, bufMgr);
+		RecordId scanRid;
+		while((int)rids.size() < 300)
+		{
+			fscan.scanNext(scanRid);
+			rids.push_back(scanRid);
+		}
+	}
+
+	for(size_t i = 0; i < rids.size(); i++)
+	{
+		index.insertEntry(&key, rids[i]);
+	}
+
+	checkPassFail(intLookup(&index,42), 301)
+	checkPassFail(intScan(&index,40,GTE,45,LT), 305)
+	checkPassFail(intScan(&index,0,GTE,5000,LT), 5300)
+
+	// posting lists remove lazily deleted entries right away
+	index.setDeleteMode(LAZY_DELETE);
+	for(size_t i = 0; i < rids.size(); i += 2)
+	{
+		index.deleteEntry(&key, rids[i]);
+	}
+
+	checkPassFail(intLookup(&index,42), 151)
+	index.setDeleteMode(EAGER_DELETE);
+	for(size_t i = 1; i < rids.size(); i += 2)
+	{
+		index.deleteEntry(&key, rids[i]);
+	}
+
+	checkPassFail(intLookup(&index,42), 1)
+	checkPassFail(intScan(&index,0,GTE,5000,LT), 5000)
+}
+
+// -----------------------------------------------------------------------------
+// packedPostingTests
+// -----------------------------------------------------------------------------
+
+void packedPostingTests()
+{
+  std::cout << "Bulk load full posting list leaves from heavily duplicated keys" << std::endl;
+	const std::string dupRelationName = "relDup";
+	const int numRecords = 30000;
+	std::string dupIntIndexName, dupDoubleIndexName;
+
+	// three distinct integers and twenty distinct doubles, so every key needs
+	// a run of posting lists
+	{
+		PageFile dupFile = PageFile::create(dupRelationName);
+		RECORD record;
+		memset(record.s, ' ', sizeof(record.s));
+		PageId pageNo;
+		Page page = dupFile.allocatePage(pageNo);
+
+		for(int i = 0; i < numRecords; i++)
+		{
+			record.i = i % 3;
+			record.d = (double)(i % 20);
+
+			while(1)
+			{
+				try
+				{
+					page.insertRecord(reinterpret_cast<char*>(&record), sizeof(record));
+					break;
+				}
+				catch(InsufficientSpaceException e)
+				{
+					dupFile.writePage(pageNo, page);
+					page = dupFile.allocatePage(pageNo);
+				}
+			}
+		}
+
+		dupFile.writePage(pageNo, page);
+	}
+
+	// leaves filled to the last byte, then split by inserts; the record ids
+	// are only counted, never read
+	{
+		BTreeIndex index(dupRelationName, dupIntIndexName, bufMgr, offsetof(tuple,i), INTEGER, 1.0, BULKLOAD_RUNSIZE, POSTING_LEAF);
+
+		checkPassFail(intLookup(&index,0), numRecords / 3)
+		checkPassFail(intLookup(&index,2), numRecords / 3)
+
+		int key = 1;
+		for(int i = 0; i < 2000; i++)
+		{
+			RecordId newRid = {(PageId)(i / 100 + 1), (SlotId)(i % 100 + 200)};
+			index.insertEntry(&key, newRid);
+		}
+
+		checkPassFail(intLookup(&index,1), numRecords / 3 + 2000)
+	}
+
+	{
+		BTreeIndex index(dupRelationName, dupDoubleIndexName, bufMgr, offsetof(tuple,d), DOUBLE, 1.0, BULKLOAD_RUNSIZE, POSTING_LEAF);
+
+		std::vector<RecordId> rids;
+		double key = 7;
+		index.lookup(&key, rids);
+		checkPassFail((int)rids.size(), numRecords / 20)
+
+		for(int i = 0; i < 2000; i++)
+		{
+			RecordId newRid = {(PageId)(i / 100 + 1), (SlotId)(i % 100 + 200)};
+			index.insertEntry(&key, newRid);
+		}
+
+		rids.clear();
+		index.lookup(&key, rids);
+		checkPassFail((int)rids.size(), numRecords / 20 + 2000)
+	}
+
+	File::remove(dupIntIndexName);
+	File::remove(dupDoubleIndexName);
+	File::remove(dupRelationName);
+}
+
+// -----------------------------------------------------------------------------
+// tailTests
+// -----------------------------------------------------------------------------
+
+void tailTests()
+{
+  std::cout << "Insert ascending keys at the tail of an empty integer index" << std::endl;
+	const std::string tailRelationName = "relTail";
+	const int numKeys = 20000;
+	std::string tailIndexName;
+
+	// the index is built over an empty relation, and its entries point at
+	// records of relA so scans can read them
+	{
+		PageFile::create(tailRelationName);
+	}
+
+	std::vector<RecordId> rids;
+	{
+		FileScan fscan(relationName, bufMgr);
+
+		try
+		{
+			RecordId scanRid;
+			while(1)
+			{
+				fscan.scanNext(scanRid);
+				rids.push_back(scanRid);
+			}
+		}
+		catch(EndOfFileException e)
+		{
+		}
+	}
+
+	{
+		BTreeIndex index(tailRelationName, tailIndexName, bufMgr, offsetof(tuple,i), INTEGER);
+
+		for(int key = 0; key < numKeys; key++)
+		{
+			index.insertEntry(&key, rids[key % rids.size()]);
+		}
+
+		// the rightmost leaf splits 90/10, so the leaves it leaves behind are
+		// nearly full instead of half full
+		bool packed = indexPages(tailIndexName) <= numKeys / (LeafNodeInt::PLAINSIZE * 8 / 10) + 3;
+		checkPassFail(packed, true)
+		checkPassFail(intScan(&index,0,GTE,numKeys,LT), numKeys)
+
+		// emptying the tail merges the leaf inserts go to into its left
+		// neighbour, which has to drop the insert hint
+		for(int key = numKeys - 1; key >= numKeys - 1000; key--)
+		{
+			index.deleteEntry(&key, rids[key % rids.size()]);
+		}
+		for(int key = numKeys - 1000; key < numKeys + 1000; key++)
+		{
+			index.insertEntry(&key, rids[key % rids.size()]);
+		}
+
+		checkPassFail(intScan(&index,numKeys - 2000,GTE,numKeys + 1000,LT), 3000)
+		checkPassFail(intScan(&index,0,GTE,numKeys + 1000,LT), numKeys + 1000)
+
+		// and so does compacting it away
+		index.setDeleteMode(LAZY_DELETE);
+		for(int key = numKeys + 999; key >= numKeys - 1000; key--)
+		{
+			index.deleteEntry(&key, rids[key % rids.size()]);
+		}
+		index.compact();
+		for(int key = numKeys - 1000; key < numKeys + 2000; key++)
+		{
+			index.insertEntry(&key, rids[key % rids.size()]);
+		}
+
+		checkPassFail(intScan(&index,numKeys - 2000,GTE,numKeys + 2000,LT), 4000)
+		checkPassFail(intScan(&index,0,GTE,numKeys + 2000,LT), numKeys + 2000)
+	}
+
+	File::remove(tailIndexName);
+	File::remove(tailRelationName);
+}
+
+// -----------------------------------------------------------------------------
+// indexPages
+// -----------------------------------------------------------------------------
+
+//number of pages allocated to an index file, free ones included
+int indexPages(const std::string &indexName)
+{
+	std::ifstream in(indexName.c_str(), std::ios::binary | std::ios::ate);
+
+	return (int)(in.tellg() / Page::SIZE);
+}
+
+int intLookupBatch(BTreeIndex * index, int firstKey, int numKeys)
+{
+  std::cout << "Batch lookup for " << numKeys << " keys from " << firstKey << std::endl;
+
+	// probe the keys in descending order, the batch sorts them
+	std::vector<int> keys;
+	std::vector<const void*> keyPtrs;
+	for(int i = numKeys - 1; i >= 0; i--)
+		keys.push_back(firstKey + i);
+	for(int i = 0; i < numKeys; i++)
+		keyPtrs.push_back(&keys[i]);
+
+	std::vector< std::vector<RecordId> > rids;
+	index->lookupBatch(&keyPtrs[0], numKeys, rids);
+
+	int found = 0;
+	for(int i = 0; i < numKeys; i++)
+		found += rids[i].size();
+
+	return found;
+}
+
+int intLookup(BTreeIndex * index, int key)
+{
+  std::cout << "Lookup for " << key << std::endl;
+
+	std::vector<RecordId> rids;
+	index->lookup(&key, rids);
+
+	return rids.size();
 }
 
 int intScan(BTreeIndex * index, int lowVal, Operator lowOp, int highVal, Operator highOp)
 {
-  RecordId scanRid;
-	Page *curPage;
+  std::cout << "Scan for ";
+  if( lowOp == GT ) { std::cout << "("; } else { std::cout << "["; }
+  std::cout << lowVal << "," << highVal;
+  if( highOp == LT ) { std::cout << ")"; } else { std::cout << "]"; }
+  std::cout << std::endl;
+
+	return indexScan(index, &lowVal, lowOp, &highVal, highOp);
+}
+
+// -----------------------------------------------------------------------------
+// deleteTests
+// -----------------------------------------------------------------------------
+
+void deleteTests()
+{
+  std::cout << "Delete from the B+ Tree index on the integer field" << std::endl;
+  BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER);
+
+	// collect the entries with keys in [1000,4000)
+	std::vector< std::pair<int, RecordId> > entries;
+	{
+		FileScan fscan(relationName, bufMgr);
+
+		try
+		{
+			RecordId scanRid;
+			while(1)
+			{
+				fscan.scanNext(scanRid);
+				std::string recordStr = fscan.getRecord();
+				int key = *((int *)(recordStr.c_str() + offsetof (RECORD, i)));
+				if( key >= 1000 && key < 4000 )
+				{
+					entries.push_back(std::make_pair(key, scanRid));
+				}
+			}
+		}
+		catch(EndOfFileException e)
+		{
+		}
+	}
+
+	for(size_t i = 0; i < entries.size(); i++)
+	{
+		index.deleteEntry(&entries[i].first, entries[i].second);
+	}
+
+	checkPassFail(intScan(&index,25,GT,40,LT), 14)
+	checkPassFail(intScan(&index,900,GTE,4100,LT), 200)
+	checkPassFail(intScan(&index,0,GTE,5000,LT), 2000)
+
+	// the entry is gone, deleting it again fails
+	int thrown = 0;
+	try
+	{
+		index.deleteEntry(&entries[0].first, entries[0].second);
+	}
+	catch(NoSuchKeyFoundException e)
+	{
+		thrown = 1;
+	}
+	checkPassFail(thrown, 1)
+
+	// put them back into the shrunk tree
+	for(size_t i = 0; i < entries.size(); i++)
+	{
+		index.insertEntry(&entries[i].first, entries[i].second);
+	}
+
+	checkPassFail(intScan(&index,3000,GTE,4000,LT), 1000)
+	checkPassFail(intScan(&index,0,GTE,5000,LT), 5000)
+
+	// lazy deletes leave tombstones behind until the index is compacted
+	index.setDeleteMode(LAZY_DELETE);
+	for(size_t i = 0; i < entries.size(); i++)
+	{
+		index.deleteEntry(&entries[i].first, entries[i].second);
+	}
 
+	checkPassFail(intScan(&index,900,GTE,4100,LT), 200)
+	index.compact();
+	checkPassFail(intScan(&index,900,GTE,4100,LT), 200)
+	checkPassFail(intScan(&index,0,GTE,5000,LT), 2000)
+
+	// a scan streaming the duplicates of a key skips those lazily deleted
+	int key = 4500;
+	for(int i = 0; i < 10; i++)
+	{
+		index.insertEntry(&key, entries[i].second);
+	}
+	for(int i = 1; i < 10; i += 2)
+	{
+		index.deleteEntry(&key, entries[i].second);
+	}
+
+	checkPassFail(intScan(&index,4500,GTE,4501,LT), 6)
+	checkPassFail(intScan(&index,0,GTE,5000,LT), 2005)
+}
+
+// -----------------------------------------------------------------------------
+// doubleTests
+// -----------------------------------------------------------------------------
+
+void doubleTests()
+{
+  std::cout << "Create a B+ Tree index on the double field" << std::endl;
+  BTreeIndex index(relationName, doubleIndexName, bufMgr, offsetof(tuple,d), DOUBLE);
+
+	// run some tests
+	checkPassFail(doubleScan(&index,25,GT,40,LT), 14)
+	checkPassFail(doubleScan(&index,20,GTE,35,LTE), 16)
+	checkPassFail(doubleScan(&index,-3,GT,3,LT), 3)
+	checkPassFail(doubleScan(&index,996,GT,1001,LT), 4)
+	checkPassFail(doubleScan(&index,0,GT,1,LT), 0)
+	checkPassFail(doubleScan(&index,300,GT,400,LT), 99)
+	checkPassFail(doubleScan(&index,3000,GTE,4000,LT), 1000)
+	checkPassFail(doubleScan(&index,24.5,GT,40.5,LT), 16)
+}
+
+int doubleScan(BTreeIndex * index, double lowVal, Operator lowOp, double highVal, Operator highOp)
+{
   std::cout << "Scan for ";
   if( lowOp == GT ) { std::cout << "("; } else { std::cout << "["; }
   std::cout << lowVal << "," << highVal;
   if( highOp == LT ) { std::cout << ")"; } else { std::cout << "]"; }
   std::cout << std::endl;
 
+	return indexScan(index, &lowVal, lowOp, &highVal, highOp);
+}
+
+// -----------------------------------------------------------------------------
+// stringTests
+// -----------------------------------------------------------------------------
+
+void stringTests()
+{
+  std::cout << "Create a B+ Tree index on the string field" << std::endl;
+  BTreeIndex index(relationName, stringIndexName, bufMgr, offsetof(tuple,s), STRING);
+
+	// run some tests
+	checkPassFail(stringScan(&index,25,GT,40,LT), 14)
+	checkPassFail(stringScan(&index,20,GTE,35,LTE), 16)
+	checkPassFail(stringScan(&index,-3,GT,3,LT), 3)
+	checkPassFail(stringScan(&index,996,GT,1001,LT), 4)
+	checkPassFail(stringScan(&index,0,GT,1,LT), 0)
+	checkPassFail(stringScan(&index,300,GT,400,LT), 99)
+	checkPassFail(stringScan(&index,3000,GTE,4000,LT), 1000)
+}
+
+int stringScan(BTreeIndex * index, int lowVal, Operator lowOp, int highVal, Operator highOp)
+{
+  char lowValStr[100];
+  char highValStr[100];
+  sprintf(lowValStr,"%05d string record",lowVal);
+  sprintf(highValStr,"%05d string record",highVal);
+
+  std::cout << "Scan for ";
+  if( lowOp == GT ) { std::cout << "("; } else { std::cout << "["; }
+  std::cout << lowValStr << "," << highValStr;
+  if( highOp == LT ) { std::cout << ")"; } else { std::cout << "]"; }
+  std::cout << std::endl;
+
+	return indexScan(index, lowValStr, lowOp, highValStr, highOp);
+}
+
+// -----------------------------------------------------------------------------
+// indexScan
+// -----------------------------------------------------------------------------
+
+int indexScan(BTreeIndex * index, const void *lowVal, Operator lowOp, const void *highVal, Operator highOp)
+{
+  RecordId scanRid;
+	Page *curPage;
+
   int numResults = 0;
 	
 	try
 	{
-  	index->startScan(&lowVal, lowOp, &highVal, highOp);
+  	index->startScan(lowVal, lowOp, highVal, highOp);
 	}
 	catch(NoSuchKeyFoundException e)
 	{
@@ -407,7 +1059,8 @@ int intScan(BTreeIndex * index, int lowVal, Operator lowOp, int highVal, Operato
 		{
 			index->scanNext(scanRid);
 			bufMgr->readPage(file1, scanRid.page_number, curPage);
-			RECORD myRec = *(reinterpret_cast<const RECORD*>(curPage->getRecord(scanRid).data()));
+			RECORD myRec;
+			curPage->getRecord(scanRid, reinterpret_cast<char*>(&myRec), sizeof(myRec));
 			bufMgr->unPinPage(file1, scanRid.page_number, false);
 
 			if( numResults < 5 )
@@ -470,13 +1123,12 @@ void errorTests()
     sprintf(record1.s, "%05d string record", i);
     record1.i = i;
     record1.d = (double)i;
-    std::string new_data(reinterpret_cast<char*>(&record1), sizeof(record1));
 
 		while(1)
 		{
 			try
 			{
-    		new_page.insertRecord(new_data);
+    		new_page.insertRecord(reinterpret_cast<char*>(&record1), sizeof(record1));
 				break;
 			}
 			catch(InsufficientSpaceException e)
@@ -555,6 +1207,104 @@ void errorTests()
 	deleteRelation();
 }
 
+// -----------------------------------------------------------------------------
+// fixedPageTests
+// -----------------------------------------------------------------------------
+
+void fixedPageTests()
+{
+	std::cout << "Fixed-length page tests" << std::endl;
+	std::cout << "-----------------------" << std::endl;
+	const std::string fixedRelationName = "relFixed";
+
+	try
+	{
+		File::remove(fixedRelationName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+
+	{
+		PageFile file = PageFile::create(fixedRelationName, sizeof(RECORD));
+		PageId pageNo;
+		Page page = file.allocatePage(pageNo);
+		checkPassFail(page.record_size(), sizeof(RECORD))
+
+		// a record of any other length is refused
+		int thrown = 0;
+		try
+		{
+			page.insertRecord(reinterpret_cast<char*>(&record1), sizeof(RECORD) - 1);
+		}
+		catch(InsufficientSpaceException e)
+		{
+			thrown = 1;
+		}
+		checkPassFail(thrown, 1)
+
+		// more records than one 32-bit word of the slot bitmap covers
+		std::vector<RecordId> rids;
+		for(int i = 0; i < 40; i++)
+		{
+			record1.i = i;
+			rids.push_back(page.insertRecord(reinterpret_cast<char*>(&record1), sizeof(RECORD)));
+		}
+		checkPassFail(rids[39].slot_number, 40)
+		checkPassFail(pageRecordCount(page), 40)
+
+		// a deleted slot is skipped, then is the first one reused
+		page.deleteRecord(rids[5]);
+		checkPassFail(pageRecordCount(page), 39)
+		record1.i = 100;
+		RecordId reused = page.insertRecord(reinterpret_cast<char*>(&record1), sizeof(RECORD));
+		checkPassFail(reused.slot_number, rids[5].slot_number)
+		checkPassFail(pageRecordCount(page), 40)
+
+		// an update rewrites the record in its slot
+		RECORD updated;
+		record1.i = 200;
+		page.updateRecord(rids[33], reinterpret_cast<char*>(&record1), sizeof(RECORD));
+		page.getRecord(rids[33], reinterpret_cast<char*>(&updated), sizeof(updated));
+		checkPassFail(updated.i, 200)
+		page.getRecord(reused, reinterpret_cast<char*>(&updated), sizeof(updated));
+		checkPassFail(updated.i, 100)
+
+		// and all of it survives a trip through the file
+		file.writePage(pageNo, page);
+		Page reread = file.readPage(pageNo);
+		checkPassFail(pageRecordCount(reread), 40)
+		reread.getRecord(rids[33], reinterpret_cast<char*>(&updated), sizeof(updated));
+		checkPassFail(updated.i, 200)
+	}
+
+	File::remove(fixedRelationName);
+}
+
+// -----------------------------------------------------------------------------
+// pageRecordCount
+// -----------------------------------------------------------------------------
+
+//counts the records of a page by iterating over it, or returns -1 if the
+//iterator doesn't visit their slots in order
+int pageRecordCount(Page &page)
+{
+	int numRecords = 0;
+	SlotId lastSlot = 0;
+
+	for(PageIterator it = page.begin(); it != page.end(); ++it)
+	{
+		if(it.getCurrentRecord().slot_number <= lastSlot)
+		{
+			return -1;
+		}
+		lastSlot = it.getCurrentRecord().slot_number;
+		numRecords++;
+	}
+
+	return numRecords;
+}
+
 void deleteRelation()
 {
 	if(file1)
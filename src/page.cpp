@@ -5,6 +5,7 @@
  * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
  */
 
+#include <algorithm>
 #include <cassert>
 
 #include <iostream>
@@ -27,45 +28,186 @@ void Page::initialize() {
   header_.free_space_upper_bound = DATA_SIZE;
   header_.num_slots = 0;
   header_.num_free_slots = 0;
+  header_.record_size = 0;
+  header_.num_columns = 0;
   header_.current_page_number = INVALID_NUMBER;
   header_.next_page_number = INVALID_NUMBER;
   //data_.assign(DATA_SIZE, char());
 	memset(data_, '\0', DATA_SIZE);
 }
 
+void Page::initializeFixed(const std::uint16_t record_size) {
+  assert(record_size > 0);
+  // Each record costs its bytes plus one bitmap bit; the bitmap is rounded up
+  // to whole words, which may push the last record out.
+  std::size_t capacity = (DATA_SIZE * 8) / (record_size * 8 + 1);
+  std::size_t bitmap_bytes = (capacity + 31) / 32 * sizeof(std::uint32_t);
+  while (capacity > 0 && bitmap_bytes + capacity * record_size > DATA_SIZE) {
+    --capacity;
+    bitmap_bytes = (capacity + 31) / 32 * sizeof(std::uint32_t);
+  }
+  header_.free_space_lower_bound = bitmap_bytes;
+  header_.free_space_upper_bound = bitmap_bytes + capacity * record_size;
+  header_.num_slots = capacity;
+  header_.num_free_slots = capacity;
+  header_.record_size = record_size;
+  header_.num_columns = 0;
+  memset(data_, '\0', DATA_SIZE);
+}
+
+void Page::initializePax(const std::uint16_t record_size,
+                         const PageColumn* columns,
+                         const std::uint16_t num_columns) {
+  assert(record_size > 0 && num_columns > 0);
+  std::size_t row_bytes = 0;
+  for (std::uint16_t i = 0; i < num_columns; ++i) {
+    assert(columns[i].size > 0 &&
+           columns[i].offset + columns[i].size <= record_size);
+    row_bytes += columns[i].size;
+  }
+  // Only the column bytes are stored, so padding in the record costs nothing.
+  std::size_t capacity = (DATA_SIZE * 8) / (row_bytes * 8 + 1);
+  while (capacity > 0 &&
+         layoutPax(capacity, columns, num_columns, NULL) > DATA_SIZE) {
+    --capacity;
+  }
+  memset(data_, '\0', DATA_SIZE);
+  header_.free_space_lower_bound = (capacity + 31) / 32 * sizeof(std::uint32_t);
+  header_.free_space_upper_bound =
+      layoutPax(capacity, columns, num_columns,
+                reinterpret_cast<PageMinipage*>(
+                    &data_[header_.free_space_lower_bound]));
+  header_.num_slots = capacity;
+  header_.num_free_slots = capacity;
+  header_.record_size = record_size;
+  header_.num_columns = num_columns;
+}
+
+std::size_t Page::layoutPax(const std::size_t capacity,
+                            const PageColumn* columns,
+                            const std::uint16_t num_columns,
+                            PageMinipage* directory) {
+  std::size_t offset = (capacity + 31) / 32 * sizeof(std::uint32_t) +
+      num_columns * sizeof(PageMinipage);
+  for (std::uint16_t i = 0; i < num_columns; ++i) {
+    std::size_t align = 1;
+    while (align < 8 && columns[i].size % (align * 2) == 0) {
+      align *= 2;
+    }
+    // The data area starts right after the header.
+    while ((sizeof(PageHeader) + offset) % align != 0) {
+      ++offset;
+    }
+    if (directory != NULL) {
+      directory[i].column = columns[i];
+      directory[i].data_offset = offset;
+    }
+    offset += capacity * columns[i].size;
+  }
+  return offset;
+}
+
 RecordId Page::insertRecord(const std::string& record_data) {
-  if (!hasSpaceForRecord(record_data)) {
+  return insertRecord(record_data.data(), record_data.length());
+}
+
+RecordId Page::insertRecord(const char* record_data,
+                            const std::size_t record_length) {
+  if (!hasSpaceForRecord(record_length)) {
     throw InsufficientSpaceException(
-        page_number(), record_data.length(), getFreeSpace());
+        page_number(), record_length, getFreeSpace());
+  }
+  if (header_.record_size != 0) {
+    const SlotId slot_number = getAvailableFixedSlot();
+    const SlotId bit = slot_number - 1;
+    getSlotBitmap()[bit / 32] |= 1u << (bit % 32);
+    --header_.num_free_slots;
+    if (header_.num_columns != 0) {
+      writePaxRecord(slot_number, record_data);
+    } else {
+      memcpy(&data_[getFixedRecordOffset(slot_number)], record_data,
+             record_length);
+    }
+    return {page_number(), slot_number};
   }
   const SlotId slot_number = getAvailableSlot();
-  insertRecordInSlot(slot_number, record_data);
+  insertRecordInSlot(slot_number, record_data, record_length);
   return {page_number(), slot_number};
 }
 
 std::string Page::getRecord(const RecordId& record_id) const {
+  if (header_.num_columns != 0) {
+    validateRecordId(record_id);
+    std::string record(header_.record_size, '\0');
+    readPaxRecord(record_id.slot_number, &record[0], record.size());
+    return record;
+  }
+  std::size_t record_length;
+  const char* record = getRecordBytes(record_id, record_length);
+  return std::string(record, record_length);
+}
+
+std::size_t Page::getRecord(const RecordId& record_id, char* record_data,
+                            const std::size_t max_length) const {
+  if (header_.num_columns != 0) {
+    validateRecordId(record_id);
+    memset(record_data, '\0', std::min<std::size_t>(max_length,
+                                                    header_.record_size));
+    readPaxRecord(record_id.slot_number, record_data, max_length);
+    return header_.record_size;
+  }
+  std::size_t record_length;
+  const char* record = getRecordBytes(record_id, record_length);
+  memcpy(record_data, record, std::min(max_length, record_length));
+  return record_length;
+}
+
+const char* Page::getRecordBytes(const RecordId& record_id,
+                                 std::size_t& record_length) const {
   validateRecordId(record_id);
+  assert(header_.num_columns == 0);
+  if (header_.record_size != 0) {
+    record_length = header_.record_size;
+    return &data_[getFixedRecordOffset(record_id.slot_number)];
+  }
   const PageSlot& slot = getSlot(record_id.slot_number);
-	std::string retStr = std::string(data_, DATA_SIZE).substr(slot.item_offset, slot.item_length);
-
-	return retStr;
+  record_length = slot.item_length;
+  return &data_[slot.item_offset];
 }
 
 void Page::updateRecord(const RecordId& record_id,
                         const std::string& record_data) {
+  updateRecord(record_id, record_data.data(), record_data.length());
+}
+
+void Page::updateRecord(const RecordId& record_id, const char* record_data,
+                        const std::size_t record_length) {
   validateRecordId(record_id);
+  if (header_.record_size != 0) {
+    if (record_length != header_.record_size) {
+      throw InsufficientSpaceException(
+          page_number(), record_length, header_.record_size);
+    }
+    if (header_.num_columns != 0) {
+      writePaxRecord(record_id.slot_number, record_data);
+    } else {
+      memcpy(&data_[getFixedRecordOffset(record_id.slot_number)], record_data,
+             record_length);
+    }
+    return;
+  }
   const PageSlot* slot = getSlot(record_id.slot_number);
   const std::size_t free_space_after_delete =
       getFreeSpace() + slot->item_length;
-  if (record_data.length() > free_space_after_delete) {
+  if (record_length > free_space_after_delete) {
     throw InsufficientSpaceException(
-        page_number(), record_data.length(), free_space_after_delete);
+        page_number(), record_length, free_space_after_delete);
   }
   // We have to disallow slot compaction here because we're going to place the
   // record data in the same slot, and compaction might delete the slot if we
   // permit it.
   deleteRecord(record_id, false /* allow_slot_compaction */);
-  insertRecordInSlot(record_id.slot_number, record_data);
+  insertRecordInSlot(record_id.slot_number, record_data, record_length);
 }
 
 void Page::deleteRecord(const RecordId& record_id) {
@@ -75,13 +217,14 @@ void Page::deleteRecord(const RecordId& record_id) {
 void Page::deleteRecord(const RecordId& record_id,
                         const bool allow_slot_compaction) {
   validateRecordId(record_id);
+  if (header_.record_size != 0) {
+    const SlotId bit = record_id.slot_number - 1;
+    getSlotBitmap()[bit / 32] &= ~(1u << (bit % 32));
+    ++header_.num_free_slots;
+    return;
+  }
   PageSlot* slot = getSlot(record_id.slot_number);
 
-	for(int i = 0; i < slot->item_length; i++)
-		data_[i + slot->item_offset] = '\0';
-
-  //data_.replace(slot->item_offset, slot->item_length, slot->item_length, '\0');
-
   // Compact the data by removing the hole left by this record (if necessary).
   std::uint16_t move_offset = slot->item_offset; 
   std::size_t move_bytes = 0;
@@ -97,15 +240,14 @@ void Page::deleteRecord(const RecordId& record_id,
       other_slot->item_offset += slot->item_length;
     }
   }
-  // If we have data to move, shift it to the right.
+  // If we have data to move, shift it to the right.  The ranges overlap when
+  // the hole is smaller than the data moved over it.
   if (move_bytes > 0) {
-    const std::string& data_to_move = std::string(data_, DATA_SIZE).substr(move_offset, move_bytes);
-
-		for(std::uint16_t i = 0; i < move_bytes; i++)
-			data_[i + move_offset + slot->item_length] = data_to_move[i];
-
-    //data_.replace(move_offset + slot->item_length, move_bytes, data_to_move);
+    memmove(&data_[move_offset + slot->item_length], &data_[move_offset],
+            move_bytes);
   }
+  // Free space stays zeroed, since new slots are carved out of it.
+  memset(&data_[move_offset], '\0', slot->item_length);
   header_.free_space_upper_bound += slot->item_length;
 
   // Mark slot as unused.
@@ -136,7 +278,15 @@ void Page::deleteRecord(const RecordId& record_id,
 }
 
 bool Page::hasSpaceForRecord(const std::string& record_data) const {
-  std::size_t record_size = record_data.length();
+  return hasSpaceForRecord(record_data.length());
+}
+
+bool Page::hasSpaceForRecord(const std::size_t record_length) const {
+  if (header_.record_size != 0) {
+    // Fixed-length pages only take records of exactly their record size.
+    return record_length == header_.record_size && header_.num_free_slots > 0;
+  }
+  std::size_t record_size = record_length;
   if (header_.num_free_slots == 0) {
     record_size += sizeof(PageSlot);
   }
@@ -175,8 +325,70 @@ SlotId Page::getAvailableSlot() {
   return static_cast<SlotId>(slot_number);
 }
 
+ColumnVector Page::getColumn(const std::uint16_t column) const {
+  assert(column < header_.num_columns);
+  const PageMinipage& minipage = getMinipages()[column];
+  const ColumnVector vector = {&data_[minipage.data_offset],
+                               minipage.column.size, header_.num_slots,
+                               getSlotBitmap()};
+  return vector;
+}
+
+void Page::writePaxRecord(const SlotId slot_number, const char* record_data) {
+  const PageMinipage* minipages = getMinipages();
+  for (std::uint16_t i = 0; i < header_.num_columns; ++i) {
+    const PageColumn& column = minipages[i].column;
+    memcpy(&data_[minipages[i].data_offset + (slot_number - 1) * column.size],
+           &record_data[column.offset], column.size);
+  }
+}
+
+void Page::readPaxRecord(const SlotId slot_number, char* record_data,
+                         const std::size_t max_length) const {
+  const PageMinipage* minipages = getMinipages();
+  for (std::uint16_t i = 0; i < header_.num_columns; ++i) {
+    const PageColumn& column = minipages[i].column;
+    if (column.offset >= max_length) {
+      continue;
+    }
+    memcpy(&record_data[column.offset],
+           &data_[minipages[i].data_offset + (slot_number - 1) * column.size],
+           std::min<std::size_t>(column.size, max_length - column.offset));
+  }
+}
+
+SlotId Page::getAvailableFixedSlot() const {
+  const std::uint32_t* bitmap = getSlotBitmap();
+  for (std::size_t word = 0; ; ++word) {
+    if (bitmap[word] != ~0u) {
+      // Bits past the last slot stay clear, but the page has a free slot, so
+      // the lowest clear bit found first belongs to a real slot.
+      return word * 32 + __builtin_ctz(~bitmap[word]) + 1;
+    }
+  }
+}
+
+SlotId Page::getNextUsedFixedSlot(const SlotId start) const {
+  const std::uint32_t* bitmap = getSlotBitmap();
+  const std::size_t num_words = (header_.num_slots + 31) / 32;
+  // Bit <start> is the slot after <start>, since slot 1 is bit 0.
+  std::size_t word = start / 32;
+  if (word >= num_words) {
+    return INVALID_SLOT;
+  }
+  std::uint32_t bits = bitmap[word] & (~0u << (start % 32));
+  while (bits == 0) {
+    if (++word == num_words) {
+      return INVALID_SLOT;
+    }
+    bits = bitmap[word];
+  }
+  return word * 32 + __builtin_ctz(bits) + 1;
+}
+
 void Page::insertRecordInSlot(const SlotId slot_number,
-                              const std::string& record_data) {
+                              const char* record_data,
+                              const std::size_t record_length) {
   if (slot_number > header_.num_slots ||
       slot_number == INVALID_SLOT) {
     throw InvalidSlotException(page_number(), slot_number);
@@ -185,23 +397,27 @@ void Page::insertRecordInSlot(const SlotId slot_number,
   if (slot->used) {
     throw SlotInUseException(page_number(), slot_number);
   }
-  const int record_length = record_data.length();
   slot->used = true;
   slot->item_length = record_length;
   slot->item_offset = header_.free_space_upper_bound - record_length;
   header_.free_space_upper_bound = slot->item_offset;
   --header_.num_free_slots;
 
-	for(int i = 0; i < slot->item_length; i++)
-		data_[i + slot->item_offset] = record_data[i];
-
-  //data_.replace(slot->item_offset, slot->item_length, record_data);
+  memcpy(&data_[slot->item_offset], record_data, record_length);
 }
 
 void Page::validateRecordId(const RecordId& record_id) const {
   if (record_id.page_number != page_number()) {
     throw InvalidRecordException(record_id, page_number());
   }
+  if (header_.record_size != 0) {
+    if (record_id.slot_number == INVALID_SLOT ||
+        record_id.slot_number > header_.num_slots ||
+        !isFixedSlotUsed(record_id.slot_number)) {
+      throw InvalidRecordException(record_id, page_number());
+    }
+    return;
+  }
   const PageSlot& slot = getSlot(record_id.slot_number);
   if (!slot.used) {
     throw InvalidRecordException(record_id, page_number());
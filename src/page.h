@@ -48,6 +48,16 @@ struct PageHeader {
    */
   SlotId num_free_slots;
 
+  /**
+   * Length of every record on a fixed-length page, or 0 on a slotted page.
+   */
+  std::uint16_t record_size;
+
+  /**
+   * Number of columns on a PAX page, or 0 if records are stored whole.
+   */
+  std::uint16_t num_columns;
+
   /**
    * Number of the page within the file.
    */
@@ -67,6 +77,8 @@ struct PageHeader {
   bool operator==(const PageHeader& rhs) const {
     return num_slots == rhs.num_slots &&
         num_free_slots == rhs.num_free_slots &&
+        record_size == rhs.record_size &&
+        num_columns == rhs.num_columns &&
         current_page_number == rhs.current_page_number &&
         next_page_number == rhs.next_page_number;
   }
@@ -93,6 +105,66 @@ struct PageSlot {
   std::uint16_t item_length;
 };
 
+/**
+ * @brief Fixed-size attribute of a record, stored in its own minipage on a PAX
+ *        page.
+ */
+struct PageColumn {
+  /**
+   * Offset of the attribute in the record.
+   */
+  std::uint16_t offset;
+
+  /**
+   * Size of the attribute in bytes.
+   */
+  std::uint16_t size;
+};
+
+/**
+ * @brief Entry of the minipage directory of a PAX page.
+ */
+struct PageMinipage {
+  /**
+   * Attribute stored in the minipage.
+   */
+  PageColumn column;
+
+  /**
+   * Offset of the minipage in the page's data area.
+   */
+  std::uint16_t data_offset;
+};
+
+/**
+ * @brief The values of one column of a PAX page.
+ *
+ * The value of slot N sits at <values> + (N - 1) * <value_size>, and is part
+ * of a record only if bit N - 1 of <used> is set.  Bits are numbered from the
+ * lowest bit of the first word.
+ */
+struct ColumnVector {
+  /**
+   * Value of slot 1.
+   */
+  const char* values;
+
+  /**
+   * Size of each value in bytes.
+   */
+  std::size_t value_size;
+
+  /**
+   * Number of slots on the page, used or not.
+   */
+  SlotId num_slots;
+
+  /**
+   * Bitmap of the slots holding records.
+   */
+  const std::uint32_t* used;
+};
+
 class PageIterator;
 
 /**
@@ -103,6 +175,15 @@ class PageIterator;
  * slots and identified by a RecordId.  Although a record's actual contents may
  * be moved on the page, accessing a record by its slot is consistent.
  *
+ * A page with a nonzero record size is a fixed-length page instead: it holds
+ * records of exactly that many bytes, has no slot array, and keeps a bitmap of
+ * the slots in use at the start of its data, followed by the records at
+ * offsets computed from their slot numbers.  A PAX page is a fixed-length
+ * page that splits each record into its columns and stores every column in a
+ * minipage of its own, so that scanning one column reads only that column's
+ * bytes.  Bytes of a record not covered by any column (such as struct padding)
+ * are not stored and read back as zeros.
+ *
  * @warning This class is not threadsafe.
  */
 class Page {
@@ -141,6 +222,17 @@ class Page {
    */
   RecordId insertRecord(const std::string& record_data);
 
+  /**
+   * Inserts a new record into the page, copying it straight from the given
+   * bytes.
+   *
+   * @param record_data    Bytes that compose the record.
+   * @param record_length  Number of bytes in the record.
+   * @return  ID of the newly inserted record.
+   */
+  RecordId insertRecord(const char* record_data,
+                        const std::size_t record_length);
+
   /**
    * Returns the record with the given ID.  Returned data is a copy of what is
    * stored on the page; use updateRecord to change it.
@@ -151,6 +243,33 @@ class Page {
    */
   std::string getRecord(const RecordId& record_id) const;
 
+  /**
+   * Copies the record with the given ID into the given buffer, truncating it
+   * to the buffer's length.  Works on every kind of page, including PAX pages.
+   *
+   * @see getRecord
+   * @param record_id    ID of the record to return.
+   * @param record_data  Buffer to copy the record into.
+   * @param max_length   Length of the buffer in bytes.
+   * @return  Length of the whole record in bytes.
+   */
+  std::size_t getRecord(const RecordId& record_id, char* record_data,
+                        const std::size_t max_length) const;
+
+  /**
+   * Returns the bytes of the record with the given ID where they sit on the
+   * page, without copying them.  The pointer stays valid while the page is
+   * pinned and not modified.  Not available on PAX pages, which do not hold
+   * records contiguously; use getRecord or getColumn there.
+   *
+   * @see getRecord
+   * @param record_id      ID of the record to return.
+   * @param record_length  Set to the length of the record in bytes.
+   * @return  Pointer to the first byte of the record.
+   */
+  const char* getRecordBytes(const RecordId& record_id,
+                             std::size_t& record_length) const;
+
   /**
    * Updates the record with the given ID, replacing its data with a new
    * version.  This is equivalent to deleting the old record and inserting a
@@ -161,10 +280,22 @@ class Page {
    */
   void updateRecord(const RecordId& record_id, const std::string& record_data);
 
+  /**
+   * Updates the record with the given ID from the given bytes.
+   *
+   * @see updateRecord
+   * @param record_id      ID of record to update.
+   * @param record_data    Updated bytes that compose the record.
+   * @param record_length  Number of bytes in the record.
+   */
+  void updateRecord(const RecordId& record_id, const char* record_data,
+                    const std::size_t record_length);
+
   /**
    * Deletes the record with the given ID.  Page is compacted upon delete to
    * ensure that data of all records is contiguous.  Slot array is compacted if
-   * the slot deleted is at the end of the slot array.
+   * the slot deleted is at the end of the slot array.  On a fixed-length page
+   * the slot is just marked free.
    *
    * @param record_id   ID of the record to delete.
    */
@@ -178,13 +309,51 @@ class Page {
    */
   bool hasSpaceForRecord(const std::string& record_data) const;
 
+  /**
+   * Returns true if the page has enough free space to hold a record of the
+   * given length.
+   *
+   * @param record_length Number of bytes in the record.
+   * @return  Whether the page can hold the record.
+   */
+  bool hasSpaceForRecord(const std::size_t record_length) const;
+
   /**
    * Returns this page's free space in bytes.
    *
    * @return  Free space in bytes.
    */
-  std::uint16_t getFreeSpace() const { return header_.free_space_upper_bound -
-                                              header_.free_space_lower_bound; }
+  std::uint16_t getFreeSpace() const {
+    if (header_.record_size != 0) {
+      return header_.num_free_slots * header_.record_size;
+    }
+    return header_.free_space_upper_bound - header_.free_space_lower_bound;
+  }
+
+  /**
+   * Returns the length of every record on this page if it is a fixed-length
+   * page, or 0 if it is a slotted page.
+   *
+   * @return  Record length in bytes.
+   */
+  std::uint16_t record_size() const { return header_.record_size; }
+
+  /**
+   * Returns the number of columns if this is a PAX page, or 0 otherwise.
+   *
+   * @return  Number of columns.
+   */
+  std::uint16_t num_columns() const { return header_.num_columns; }
+
+  /**
+   * Returns the values of the given column of a PAX page where they sit on
+   * the page.  The vector stays valid while the page is pinned and not
+   * modified.
+   *
+   * @param column  Index of the column, less than num_columns().
+   * @return  The column's values.
+   */
+  ColumnVector getColumn(const std::uint16_t column) const;
 
   /**
    * Returns this page's number in its file.
@@ -221,6 +390,43 @@ class Page {
    */
   void initialize();
 
+  /**
+   * Formats this page as an empty fixed-length page holding records of the
+   * given length.  Keeps the page's number and next page number.
+   *
+   * @param record_size   Length of every record in bytes.
+   */
+  void initializeFixed(const std::uint16_t record_size);
+
+  /**
+   * Formats this page as an empty PAX page holding records of the given
+   * length split into the given columns.  Keeps the page's number and next
+   * page number.
+   *
+   * @param record_size   Length of every record in bytes.
+   * @param columns       Columns to store, each within the record.
+   * @param num_columns   Number of columns.
+   */
+  void initializePax(const std::uint16_t record_size,
+                     const PageColumn* columns,
+                     const std::uint16_t num_columns);
+
+  /**
+   * Computes where the minipages of a PAX page holding <capacity> records go.
+   * Each minipage is aligned to its value size, up to 8 bytes, counting from
+   * the start of the page.
+   *
+   * @param capacity      Number of records on the page.
+   * @param columns       Columns of the records.
+   * @param num_columns   Number of columns.
+   * @param directory     If not null, filled with one entry per column.
+   * @return  Offset in the data area of the end of the last minipage.
+   */
+  static std::size_t layoutPax(const std::size_t capacity,
+                               const PageColumn* columns,
+                               const std::uint16_t num_columns,
+                               PageMinipage* directory);
+
   /**
    * Sets this page's number in its file.
    *
@@ -288,6 +494,90 @@ class Page {
    */
   SlotId getAvailableSlot();
 
+  /**
+   * Returns the bitmap of slots in use on a fixed-length page, one bit per
+   * slot starting with slot 1 in the lowest bit of the first word.
+   *
+   * @return  Pointer to the first bitmap word.
+   */
+  std::uint32_t* getSlotBitmap() {
+    return reinterpret_cast<std::uint32_t*>(&data_[0]);
+  }
+
+  const std::uint32_t* getSlotBitmap() const {
+    return reinterpret_cast<const std::uint32_t*>(&data_[0]);
+  }
+
+  /**
+   * Returns the minipage directory of a PAX page, which follows the slot
+   * bitmap.
+   *
+   * @return  Pointer to the first directory entry.
+   */
+  const PageMinipage* getMinipages() const {
+    return reinterpret_cast<const PageMinipage*>(
+        &data_[header_.free_space_lower_bound]);
+  }
+
+  /**
+   * Copies a record into the given slot of a PAX page, a column at a time.
+   *
+   * @param slot_number   Number of slot.
+   * @param record_data   Bytes that compose the record.
+   */
+  void writePaxRecord(const SlotId slot_number, const char* record_data);
+
+  /**
+   * Assembles the record in the given slot of a PAX page from its columns.
+   *
+   * @param slot_number   Number of slot.
+   * @param record_data   Filled with the record, up to <max_length> bytes.
+   * @param max_length    Length of the buffer in bytes.
+   */
+  void readPaxRecord(const SlotId slot_number, char* record_data,
+                     const std::size_t max_length) const;
+
+  /**
+   * Returns whether the given slot of a fixed-length page holds a record.
+   *
+   * @param slot_number   Number of slot to test.
+   * @return  True if the slot is in use.
+   */
+  bool isFixedSlotUsed(const SlotId slot_number) const {
+    const SlotId bit = slot_number - 1;
+    return (getSlotBitmap()[bit / 32] >> (bit % 32)) & 1;
+  }
+
+  /**
+   * Returns the offset in the data area of the record in the given slot of a
+   * fixed-length page.  The records follow the slot bitmap, which ends at the
+   * free space lower bound.
+   *
+   * @param slot_number   Number of slot.
+   * @return  Offset of the record's first byte.
+   */
+  std::size_t getFixedRecordOffset(const SlotId slot_number) const {
+    return header_.free_space_lower_bound +
+        (slot_number - 1) * static_cast<std::size_t>(header_.record_size);
+  }
+
+  /**
+   * Returns the lowest free slot of a fixed-length page, found a bitmap word
+   * at a time.  Callers must make sure the page has a free slot.
+   *
+   * @return  Slot number of an unused slot.
+   */
+  SlotId getAvailableFixedSlot() const;
+
+  /**
+   * Returns the next used slot of a fixed-length page after the given slot or
+   * INVALID_SLOT if no slots are used after it.
+   *
+   * @param start   Slot to start search at.
+   * @return  Next used slot after given slot or INVALID_SLOT.
+   */
+  SlotId getNextUsedFixedSlot(const SlotId start) const;
+
   /**
    * Inserts record data into the given slot.  The slot should not be currently
    * in use.  <slot_number> must be less than <header_.num_slots>.
@@ -297,12 +587,14 @@ class Page {
    *
    * @param slot_number   Number of slot to insert record into.
    * @param record_data   Bytes that compose the record.
+   * @param record_length Number of bytes in the record.
    * @throws  InvalidSlotException  Thrown when given slot number refers to an
    *                                unallocated slot.
    * @throws  SlotInUseException  Thrown when given slot is in use.
    */
   void insertRecordInSlot(const SlotId slot_number,
-                          const std::string& record_data);
+                          const char* record_data,
+                          const std::size_t record_length);
 
   /**
    * Throws an exception if the given record ID is not valid for this page
@@ -109,6 +109,9 @@ class PageIterator {
    * @return  Next used slot after given slot or Page::INVALID_SLOT.
    */
   SlotId getNextUsedSlot(const SlotId start) const {
+    if (page_->header_.record_size != 0) {
+      return page_->getNextUsedFixedSlot(start);
+    }
     SlotId slot_number = Page::INVALID_SLOT;
     for (SlotId i = start + 1; i <= page_->header_.num_slots; ++i) {
       const PageSlot* slot = page_->getSlot(i);